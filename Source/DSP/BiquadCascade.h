@@ -0,0 +1,236 @@
+/*
+  ==============================================================================
+
+    BiquadCascade.h
+    Created: 17 Oct 2026 2:36:20pm
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Denormals.h"
+
+//normalised biquad coefficients (a0 == 1)
+struct BiquadCoefficients
+{
+    float b0 = 1.f, b1 = 0.f, b2 = 0.f, a1 = 0.f, a2 = 0.f;
+
+    bool operator== (const BiquadCoefficients&) const = default;
+};
+
+/*
+ RBJ cookbook designs, matching juce::dsp::IIR::Coefficients but returning plain values
+ instead of a heap allocated, ref-counted object.
+ */
+namespace BiquadDesign
+{
+inline BiquadCoefficients normalise(double b0, double b1, double b2, double a0, double a1, double a2)
+{
+    const auto invA0 = 1.0 / a0;
+    return { static_cast<float>(b0 * invA0), static_cast<float>(b1 * invA0), static_cast<float>(b2 * invA0),
+             static_cast<float>(a1 * invA0), static_cast<float>(a2 * invA0) };
+}
+
+inline BiquadCoefficients makePeak(double sampleRate, double frequency, double Q, double gainFactor)
+{
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency <= sampleRate * 0.5 && Q > 0.0);
+
+    const auto A = std::sqrt(juce::jmax(gainFactor, 1.0e-6));
+    const auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    const auto alpha = std::sin(omega) / (Q * 2.0);
+    const auto c2 = -2.0 * std::cos(omega);
+    const auto alphaTimesA = alpha * A;
+    const auto alphaOverA = alpha / A;
+
+    return normalise(1.0 + alphaTimesA, c2, 1.0 - alphaTimesA, 1.0 + alphaOverA, c2, 1.0 - alphaOverA);
+}
+
+inline BiquadCoefficients makeBandPass(double sampleRate, double frequency, double Q)
+{
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency <= sampleRate * 0.5 && Q > 0.0);
+
+    const auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    const auto nSquared = n * n;
+    const auto invQ = 1.0 / Q;
+
+    return normalise(n * invQ, 0.0, -n * invQ, 1.0 + invQ * n + nSquared, 2.0 * (1.0 - nSquared), 1.0 - invQ * n + nSquared);
+}
+
+inline BiquadCoefficients makeNotch(double sampleRate, double frequency, double Q)
+{
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency <= sampleRate * 0.5 && Q > 0.0);
+
+    const auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    const auto nSquared = n * n;
+    const auto invQ = 1.0 / Q;
+
+    return normalise(1.0 + nSquared, 2.0 * (1.0 - nSquared), 1.0 + nSquared, 1.0 + invQ * n + nSquared, 2.0 * (1.0 - nSquared), 1.0 - invQ * n + nSquared);
+}
+
+inline BiquadCoefficients makeAllPass(double sampleRate, double frequency, double Q)
+{
+    jassert(sampleRate > 0.0 && frequency > 0.0 && frequency <= sampleRate * 0.5 && Q > 0.0);
+
+    const auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+    const auto nSquared = n * n;
+    const auto invQ = 1.0 / Q;
+    const auto a0 = 1.0 + invQ * n + nSquared;
+
+    return normalise(1.0 - n * invQ + nSquared, 2.0 * (1.0 - nSquared), a0, a0, 2.0 * (1.0 - nSquared), 1.0 - n * invQ + nSquared);
+}
+}
+
+/*
+ Transposed direct-form II biquads in series, all sharing one set of coefficients.
+ SampleType is normally SIMDRegister<float> so every lane (channel) runs in one pass.
+ Each stage processes the whole block before the next so its coefficients stay in registers.
+
+ New coefficients are never applied as a jump: each stage ramps linearly from its current
+ coefficients to the target over the next processed block, so the state is never reset
+ and parameter changes don't click. Stages entering or leaving the cascade ramp from/to
+ a pass-through.
+ */
+template <typename SampleType, size_t MaxStages>
+struct BiquadCascade
+{
+    //clears the filter state. The next setCoefficients() call is applied immediately instead of ramped.
+    void reset()
+    {
+        for (auto& s : state)
+            s = {};
+
+        snapToTarget = true;
+    }
+
+    void setCoefficients(const BiquadCoefficients& newCoefficients, size_t numStagesToUse)
+    {
+        jassert(numStagesToUse >= 1 && numStagesToUse <= MaxStages);
+        numStages = juce::jlimit<size_t>(1, MaxStages, numStagesToUse);
+        target = newCoefficients;
+
+        if (snapToTarget)
+        {
+            for (size_t stage = 0; stage < MaxStages; ++stage)
+                current[stage] = getTargetForStage(stage);
+
+            snapToTarget = false;
+        }
+    }
+
+    size_t getNumStages() const { return numStages; }
+
+    void process(const juce::dsp::AudioBlock<SampleType>& block)
+    {
+        jassert(block.getNumChannels() == 1);
+
+        const auto numSamples = block.getNumSamples();
+        if (numSamples == 0)
+            return;
+
+        auto* samples = block.getChannelPointer(0);
+
+        for (size_t stage = 0; stage < MaxStages; ++stage)
+        {
+            const auto& stageTarget = getTargetForStage(stage);
+            auto& stageCoefficients = current[stage];
+
+            if (stageCoefficients == stageTarget)
+            {
+                if (stage >= numStages)
+                {
+                    //fully faded out, so it restarts from silence when it comes back.
+                    state[stage] = {};
+                    continue;
+                }
+
+                processStage(samples, numSamples, state[stage], stageCoefficients);
+            }
+            else
+            {
+                processStageRamped(samples, numSamples, state[stage], stageCoefficients, stageTarget);
+                stageCoefficients = stageTarget;
+            }
+
+            state[stage].s1 = Denormals::flush(state[stage].s1);
+            state[stage].s2 = Denormals::flush(state[stage].s2);
+        }
+    }
+
+private:
+    struct StageState
+    {
+        SampleType s1 {}, s2 {};
+    };
+
+    const BiquadCoefficients& getTargetForStage(size_t stage) const
+    {
+        static const BiquadCoefficients passThrough;
+        return stage < numStages ? target : passThrough;
+    }
+
+    static void processStage(SampleType* samples, size_t numSamples, StageState& stageState, const BiquadCoefficients& c)
+    {
+        const auto b0 = SampleType(c.b0);
+        const auto b1 = SampleType(c.b1);
+        const auto b2 = SampleType(c.b2);
+        const auto a1 = SampleType(c.a1);
+        const auto a2 = SampleType(c.a2);
+
+        auto s1 = stageState.s1;
+        auto s2 = stageState.s2;
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto x = samples[i];
+            const auto y = b0 * x + s1;
+            s1 = b1 * x - a1 * y + s2;
+            s2 = b2 * x - a2 * y;
+            samples[i] = y;
+        }
+
+        stageState.s1 = s1;
+        stageState.s2 = s2;
+    }
+
+    static void processStageRamped(SampleType* samples, size_t numSamples, StageState& stageState,
+                                   const BiquadCoefficients& from, const BiquadCoefficients& to)
+    {
+        const auto step = 1.f / static_cast<float>(numSamples);
+        const BiquadCoefficients delta
+        {
+            (to.b0 - from.b0) * step, (to.b1 - from.b1) * step, (to.b2 - from.b2) * step,
+            (to.a1 - from.a1) * step, (to.a2 - from.a2) * step
+        };
+
+        auto c = from;
+        auto s1 = stageState.s1;
+        auto s2 = stageState.s2;
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            c.b0 += delta.b0;
+            c.b1 += delta.b1;
+            c.b2 += delta.b2;
+            c.a1 += delta.a1;
+            c.a2 += delta.a2;
+
+            const auto x = samples[i];
+            const auto y = SampleType(c.b0) * x + s1;
+            s1 = SampleType(c.b1) * x - SampleType(c.a1) * y + s2;
+            s2 = SampleType(c.b2) * x - SampleType(c.a2) * y;
+            samples[i] = y;
+        }
+
+        stageState.s1 = s1;
+        stageState.s2 = s2;
+    }
+
+    std::array<StageState, MaxStages> state {};
+    std::array<BiquadCoefficients, MaxStages> current {};
+    BiquadCoefficients target;
+    size_t numStages = 1;
+    bool snapToTarget = true;
+};
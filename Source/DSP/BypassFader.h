@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    BypassFader.h
+    Created: 23 Oct 2026 9:48:20am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Bypass for one stage. A stage that is bypassed and faded out does no work at all.
+ Toggling the bypass fades the stage's output against its input with an equal-power
+ crossfade over FadeSeconds, so it doesn't click. When the stage comes back after being
+ fully bypassed, takeResume() returns true once so the owner can reset and update it
+ before processing. Nothing is recomputed while the stage is off.
+ */
+struct BypassFader
+{
+    static constexpr double FadeSeconds = 0.01;
+
+    void prepare(double sampleRate, int numChannels, int maxBlockSize)
+    {
+        fadeLength = juce::jmax(1, juce::roundToInt(FadeSeconds * sampleRate));
+
+        //a quarter sine. The dry gain reads it backwards, so wet^2 + dry^2 == 1 all the way through.
+        gainTable.allocate(static_cast<size_t>(fadeLength) + 1, false);
+        for (int i = 0; i <= fadeLength; ++i)
+            gainTable[i] = static_cast<float>(std::sin(juce::MathConstants<double>::halfPi * i / fadeLength));
+
+        dryBuffer.setSize(numChannels, maxBlockSize);
+        wetGains.allocate(static_cast<size_t>(maxBlockSize), true);
+        dryGains.allocate(static_cast<size_t>(maxBlockSize), true);
+    }
+
+    //jumps straight to the given state without a fade
+    void reset(bool shouldBeBypassed)
+    {
+        bypassed = shouldBeBypassed;
+        position = bypassed ? 0 : fadeLength;
+        resumePending = false;
+    }
+
+    void setBypassed(bool shouldBeBypassed)
+    {
+        if (shouldBeBypassed == false && isFullyBypassed())
+            resumePending = true;
+
+        bypassed = shouldBeBypassed;
+    }
+
+    bool isFullyBypassed() const { return bypassed && position == 0; }
+    bool isFading() const { return position != getTarget(); }
+
+    //true once after a fully bypassed stage is switched back on. Its state is from before it was bypassed.
+    bool takeResume() { return std::exchange(resumePending, false); }
+
+    void pushDry(const juce::dsp::AudioBlock<float>& block)
+    {
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+            dryBuffer.copyFrom(static_cast<int>(ch), 0, block.getChannelPointer(ch), numSamples);
+    }
+
+    //the copy made by the last pushDry(), e.g. to delay it by the stage's latency
+    juce::dsp::AudioBlock<float> getDryBlock(size_t numChannels, size_t numSamples)
+    {
+        return juce::dsp::AudioBlock<float>(dryBuffer).getSubsetChannelBlock(0, numChannels).getSubBlock(0, numSamples);
+    }
+
+    //out = wet * sin + dry * cos, moving the fade along by the block's length
+    void mix(const juce::dsp::AudioBlock<float>& block)
+    {
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        const auto target = getTarget();
+        const auto step = position < target ? 1 : -1;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            wetGains[i] = gainTable[position];
+            dryGains[i] = gainTable[fadeLength - position];
+            if (position != target)
+                position += step;
+        }
+
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+        {
+            auto* wet = block.getChannelPointer(ch);
+            juce::FloatVectorOperations::multiply(wet, wetGains.get(), numSamples);
+            juce::FloatVectorOperations::addWithMultiply(wet, dryBuffer.getReadPointer(static_cast<int>(ch)), dryGains.get(), numSamples);
+        }
+    }
+private:
+    int getTarget() const { return bypassed ? 0 : fadeLength; }
+    juce::AudioBuffer<float> dryBuffer;
+    juce::HeapBlock<float> gainTable, wetGains, dryGains;
+    int fadeLength = 1, position = 1;
+    bool bypassed = false, resumePending = false;
+};
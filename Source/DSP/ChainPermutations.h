@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    ChainPermutations.h
+    Created: 17 Oct 2026 11:02:37am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+/*
+ Every ordering of the N values of an enum, computed at compile time in lexicographic
+ order. Used to stamp out one statically dispatched process function per ordering.
+ */
+namespace ChainPermutations
+{
+constexpr size_t factorial(size_t n)
+{
+    return n <= 1 ? 1 : n * factorial(n - 1);
+}
+
+template <typename Enum, size_t N>
+using Order = std::array<Enum, N>;
+
+template <typename Enum, size_t N>
+constexpr auto makeAll()
+{
+    std::array<Order<Enum, N>, factorial(N)> result {};
+
+    Order<Enum, N> order {};
+    for (size_t i = 0; i < N; ++i)
+        order[i] = static_cast<Enum>(i);
+
+    size_t index = 0;
+    do
+    {
+        result[index++] = order;
+    }
+    while (std::next_permutation(order.begin(), order.end()));
+
+    return result;
+}
+
+template <typename Enum, size_t N>
+inline constexpr auto all = makeAll<Enum, N>();
+
+/*
+ returns the index of order in all<Enum, N>, or -1 if order is not a permutation
+ (i.e. it contains duplicates or END_OF_LIST).
+ */
+template <typename Enum, size_t N>
+constexpr int indexOf(const Order<Enum, N>& order)
+{
+    std::array<bool, N> used {};
+    size_t index = 0;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        auto value = static_cast<size_t>(order[i]);
+        if (value >= N || used[value])
+            return -1;
+
+        //lehmer code: how many unused values are smaller than this one
+        size_t smallerUnused = 0;
+        for (size_t v = 0; v < value; ++v)
+            smallerUnused += used[v] ? 0 : 1;
+
+        used[value] = true;
+        index += smallerUnused * factorial(N - 1 - i);
+    }
+
+    return static_cast<int>(index);
+}
+}
@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    ChannelSide.h
+    Created: 28 Oct 2026 11:04:31am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDLanes.h"
+
+/*
+ Where each channel of a bus sits, taken from the bus's AudioChannelSet. The stereo stages
+ (chorus spread, ping-pong delay) pair lefts with rights by it in any layout instead of
+ taking even channels for left, and the modulation stages leave the LFE untouched.
+ */
+enum class ChannelSide
+{
+    Left,
+    Right,
+    Centre, //centre and mono, and anything else on neither side
+    LFE,
+};
+
+//one per lane of a channel group, i.e. per channel of a ChannelChainDSP
+using LaneSides = std::array<ChannelSide, SIMDLanes::NumLanes>;
+
+inline ChannelSide getChannelSide(juce::AudioChannelSet::ChannelType type)
+{
+    using Set = juce::AudioChannelSet;
+    switch (type)
+    {
+        case Set::left:
+        case Set::leftCentre:
+        case Set::leftSurround:
+        case Set::leftSurroundSide:
+        case Set::leftSurroundRear:
+        case Set::wideLeft:
+        case Set::topFrontLeft:
+        case Set::topSideLeft:
+        case Set::topRearLeft:
+            return ChannelSide::Left;
+        case Set::right:
+        case Set::rightCentre:
+        case Set::rightSurround:
+        case Set::rightSurroundSide:
+        case Set::rightSurroundRear:
+        case Set::wideRight:
+        case Set::topFrontRight:
+        case Set::topSideRight:
+        case Set::topRearRight:
+            return ChannelSide::Right;
+        case Set::LFE:
+        case Set::LFE2:
+            return ChannelSide::LFE;
+        default:
+            return ChannelSide::Centre;
+    }
+}
+
+//the sides of the channels of layout in channel group 'group'. Lanes past the last channel are Centre.
+inline LaneSides getLaneSides(const juce::AudioChannelSet& layout, size_t group)
+{
+    LaneSides sides;
+    sides.fill(ChannelSide::Centre);
+    for (size_t lane = 0; lane < sides.size(); ++lane)
+    {
+        auto channel = static_cast<int>(group * SIMDLanes::NumLanes + lane);
+        if (channel < layout.size())
+            sides[lane] = getChannelSide(layout.getTypeOfChannel(channel));
+    }
+    return sides;
+}
@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+
+    ChorusEngine.h
+    Created: 20 Oct 2026 4:31:12pm
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDLanes.h"
+#include "SineLFO.h"
+#include "Denormals.h"
+#include "ChannelSide.h"
+
+/*
+ Multi-voice chorus running every channel as a lane of an interleaved SIMDLanes block.
+ One power-of-two ring buffer of registers holds every channel's delay line, and each voice
+ is a tap into it, so a voice's interpolation covers all channels at once.
+ All voices share a single LFO: each voice is offset by an equal share of the cycle and each
+ right channel by up to half that share, so its taps fall between the left channels'. Centre
+ channels sit halfway between and the LFE passes through dry. The offsets are taken from the
+ LFO's quadrature output.
+ With one voice and no spread it is a drop-in for juce::dsp::Chorus<float> at mix 1.
+ Modulation depth, feedback and rate glide over 50ms the way juce's chorus does.
+ */
+struct ChorusEngine
+{
+    using Register = SIMDLanes::Register;
+
+    static constexpr float MaxCentreDelayMs = 100.f;
+    static constexpr float MaxDelayModulationMs = 20.f;
+    static constexpr size_t MaxVoices = 8;
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        samplesPerMs = static_cast<float>(sampleRate / 1000.0);
+        const auto maxDepthMs = MaxDelayModulationMs * OscVolumeMultiplier + MaxCentreDelayMs;
+        maxDelaySamples = static_cast<float>(std::ceil(maxDepthMs * sampleRate / 1000.0));
+        const auto size = static_cast<size_t>(juce::nextPowerOfTwo(static_cast<int>(maxDelaySamples) + 2));
+        ring.allocate(size, true);
+        mask = size - 1;
+        lfo.prepare(sampleRate);
+        updateVoiceOffsets();
+        update();
+        reset();
+    }
+
+    void reset()
+    {
+        lastOutput = Register::expand(0.f);
+        for (size_t i = 0; i <= mask; ++i)
+            ring[i] = Register::expand(0.f);
+        writeIndex = 0;
+        lfo.reset();
+        oscVolume.reset(sampleRate, 0.05);
+        feedbackVolume.reset(sampleRate, 0.05);
+    }
+
+    void setRate(float hz) { rate = hz; update(); }
+    void setDepth(float newDepth) { depth = juce::jlimit(0.f, 1.f, newDepth); update(); }
+    void setCentreDelay(float ms) { centreDelay = juce::jlimit(1.f, MaxCentreDelayMs, ms); }
+    void setFeedback(float newFeedback) { feedback = juce::jlimit(-1.f, 1.f, newFeedback); update(); }
+
+    void setVoices(int newNumVoices)
+    {
+        auto voices = static_cast<size_t>(juce::jlimit(1, static_cast<int>(MaxVoices), newNumVoices));
+        if (voices == numVoices)
+            return;
+        numVoices = voices;
+        updateVoiceOffsets();
+    }
+
+    //the side of each lane's channel, from the bus layout
+    void setChannelSides(const LaneSides& newSides)
+    {
+        sides = newSides;
+        for (size_t lane = 0; lane < SIMDLanes::NumLanes; ++lane)
+        {
+            wetLanes.set(lane, sides[lane] == ChannelSide::LFE ? 0.f : 1.f);
+            dryLanes.set(lane, sides[lane] == ChannelSide::LFE ? 1.f : 0.f);
+        }
+        updateVoiceOffsets();
+    }
+
+    //0 puts every channel on the same LFO phase, 1 puts the right channels' voices halfway between the left's
+    void setSpread(float newSpread)
+    {
+        newSpread = juce::jlimit(0.f, 1.f, newSpread);
+        if (newSpread == spread)
+            return;
+        spread = newSpread;
+        updateVoiceOffsets();
+    }
+
+    void process(const juce::dsp::AudioBlock<Register>& block)
+    {
+        auto* samples = block.getChannelPointer(0);
+        const auto numSamples = block.getNumSamples();
+        const auto* ringSamples = reinterpret_cast<const float*>(ring.get());
+        const auto voiceGain = 1.f / static_cast<float>(numVoices);
+        const auto minDelayMs = Register::expand(1.f), maxDelay = Register::expand(maxDelaySamples);
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            float quadrature = 0.f;
+            auto value = lfo.processSample(quadrature);
+            auto modulation = MaxDelayModulationMs * oscVolume.getNextValue();
+            const auto input = samples[i];
+            //flushed on the way in, so the ring never holds a decaying feedback tail below the threshold
+            ring[writeIndex] = Denormals::flush(input - lastOutput);
+            auto output = Register::expand(0.f);
+            for (size_t voice = 0; voice < numVoices; ++voice)
+            {
+                auto lfoValue = voiceCos[voice] * value + voiceSin[voice] * quadrature;
+                auto delaySamples = Register::min(Register::max(minDelayMs, lfoValue * modulation + centreDelay) * samplesPerMs, maxDelay);
+                auto wholeSamples = truncate(delaySamples);
+                //every lane taps the ring at its own delay, so only the reads are per lane
+                Register newer, older;
+                for (size_t lane = 0; lane < SIMDLanes::NumLanes; ++lane)
+                {
+                    auto delayInt = static_cast<size_t>(wholeSamples.get(lane));
+                    newer.set(lane, ringSamples[((writeIndex - delayInt) & mask) * SIMDLanes::NumLanes + lane]);
+                    older.set(lane, ringSamples[((writeIndex - delayInt - 1) & mask) * SIMDLanes::NumLanes + lane]);
+                }
+                output += newer + (older - newer) * (delaySamples - wholeSamples);
+            }
+            output *= voiceGain;
+            samples[i] = output * wetLanes + input * dryLanes;
+            lastOutput = output * feedbackVolume.getNextValue();
+            writeIndex = (writeIndex + 1) & mask;
+        }
+        lastOutput = Denormals::flush(lastOutput);
+    }
+private:
+    static constexpr float OscVolumeMultiplier = 0.5f;
+    double sampleRate = 44100.0;
+    float samplesPerMs = 44.1f;
+    float rate = 1.f, depth = 0.25f, centreDelay = 7.f, feedback = 0.f; //juce::dsp::Chorus defaults
+    float maxDelaySamples = 0.f;
+    size_t numVoices = 1;
+    float spread = 0.f;
+    LaneSides sides = getLaneSides(juce::AudioChannelSet::stereo(), 0);
+    Register wetLanes = Register::expand(1.f), dryLanes = Register::expand(0.f); //1 and 0 per lane, swapped for the LFE
+
+    //cos and sin of each voice's phase offset, per lane
+    std::array<Register, MaxVoices> voiceCos, voiceSin;
+    SineLFO lfo;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> oscVolume, feedbackVolume;
+    juce::HeapBlock<Register> ring;
+    size_t mask = 0, writeIndex = 0;
+    Register lastOutput;
+
+    //the whole part of positive values below 2^23. Adding and taking away 2^23 rounds to the nearest
+    //whole number, which is one too many wherever it rounded up.
+    static Register truncate(Register x)
+    {
+        const auto roundingConstant = Register::expand(8388608.f);
+        auto rounded = (x + roundingConstant) - roundingConstant;
+        return rounded - (Register::expand(1.f) & Register::greaterThan(rounded, x));
+    }
+
+    void update()
+    {
+        lfo.setFrequency(rate);
+        oscVolume.setTargetValue(depth * OscVolumeMultiplier);
+        feedbackVolume.setTargetValue(feedback);
+    }
+
+    //how far across the spread a side sits: lefts 0, rights 1
+    static double getSpreadPosition(ChannelSide side)
+    {
+        return side == ChannelSide::Right ? 1.0 : side == ChannelSide::Centre ? 0.5 : 0.0;
+    }
+
+    void updateVoiceOffsets()
+    {
+        for (size_t voice = 0; voice < numVoices; ++voice)
+        {
+            for (size_t lane = 0; lane < SIMDLanes::NumLanes; ++lane)
+            {
+                auto offset = juce::MathConstants<double>::twoPi * static_cast<double>(voice) / static_cast<double>(numVoices)
+                            + juce::MathConstants<double>::pi * spread * getSpreadPosition(sides[lane]) / static_cast<double>(numVoices);
+                voiceCos[voice].set(lane, static_cast<float>(std::cos(offset)));
+                voiceSin[voice].set(lane, static_cast<float>(std::sin(offset)));
+            }
+        }
+    }
+};
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    CompensationDelay.h
+    Created: 21 Oct 2026 3:58:14pm
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Whole-sample delay that lines a path up with a parallel path that has more latency.
+ Blocks go into and out of a power-of-two ring per channel with at most two contiguous
+ copies each way. The ring is sized in prepare() for the largest delay that can be set.
+ */
+struct CompensationDelay
+{
+    void prepare(int numChannels, int newMaxDelay, int maxBlockSize)
+    {
+        maxDelay = juce::jmax(0, newMaxDelay);
+        auto size = juce::nextPowerOfTwo(maxDelay + maxBlockSize);
+        mask = size - 1;
+        ring.setSize(numChannels, size);
+        reset();
+    }
+
+    void reset()
+    {
+        ring.clear();
+        writeIndex = 0;
+    }
+
+    void setDelay(int newDelay) { delay = juce::jlimit(0, maxDelay, newDelay); }
+    int getDelay() const { return delay; }
+
+    void process(const juce::dsp::AudioBlock<float>& block)
+    {
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        const auto size = ring.getNumSamples();
+        const auto numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), ring.getNumChannels());
+        //written even with no delay, so a later delay has history to read
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* samples = block.getChannelPointer(static_cast<size_t>(ch));
+            auto first = juce::jmin(numSamples, size - writeIndex);
+            juce::FloatVectorOperations::copy(ring.getWritePointer(ch, writeIndex), samples, first);
+            if (first < numSamples)
+                juce::FloatVectorOperations::copy(ring.getWritePointer(ch), samples + first, numSamples - first);
+
+            if (delay == 0)
+                continue;
+
+            auto readIndex = (writeIndex - delay) & mask;
+            first = juce::jmin(numSamples, size - readIndex);
+            juce::FloatVectorOperations::copy(samples, ring.getReadPointer(ch, readIndex), first);
+            if (first < numSamples)
+                juce::FloatVectorOperations::copy(samples + first, ring.getReadPointer(ch), numSamples - first);
+        }
+        writeIndex = (writeIndex + numSamples) & mask;
+    }
+private:
+    juce::AudioBuffer<float> ring;
+    int maxDelay = 0, delay = 0, mask = 0, writeIndex = 0;
+};
@@ -0,0 +1,239 @@
+/*
+  ==============================================================================
+
+    DelayEngine.h
+    Created: 21 Oct 2026 11:02:19am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Denormals.h"
+#include "ChannelSide.h"
+
+/*
+ Feedback delay on a power-of-two ring buffer per channel, sized in prepare() for
+ MaxDelaySeconds. Work is done in chunks no longer than the delay, so every chunk is read
+ out of and written into the ring with at most two contiguous copies and no per-sample
+ push/pop. The feedback path has a one-pole low cut and high cut, and ping-pong mode pairs
+ each left channel with a right one, feeds the pair's mono sum into the left and cross-feeds
+ the two. Centre channels, the LFE and unpaired channels stay as they are in stereo mode.
+ Delay time changes crossfade between the old and new read positions.
+ */
+struct DelayEngine
+{
+    static constexpr float MaxDelaySeconds = 4.f;
+    static constexpr float MinDelayMs = 1.f;
+    //the ends of the cut ranges switch the feedback filters off
+    static constexpr float MinLowCutHz = 20.f;
+    static constexpr float MaxHighCutHz = 20000.f;
+    static constexpr double CrossfadeSeconds = 0.02;
+
+    static juce::StringArray getSyncChoices()
+    {
+        return { "Off", "1/32", "1/16", "1/16 Dotted", "1/8 Triplet", "1/8", "1/8 Dotted", "1/4 Triplet", "1/4", "1/4 Dotted", "1/2", "1/1" };
+    }
+
+    //length of a getSyncChoices() entry in quarter notes. 0 for "Off".
+    static double getSyncBeats(int syncIndex)
+    {
+        static constexpr std::array<double, 12> beats { 0.0, 0.125, 0.25, 0.375, 1.0 / 3.0, 0.5, 0.75, 2.0 / 3.0, 1.0, 1.5, 2.0, 4.0 };
+        return beats[static_cast<size_t>(juce::jlimit(0, static_cast<int>(beats.size()) - 1, syncIndex))];
+    }
+
+    static juce::StringArray getModeChoices() { return { "Stereo", "Ping Pong" }; }
+
+    DelayEngine() { setChannelSides(getLaneSides(juce::AudioChannelSet::stereo(), 0)); }
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        numChannels = static_cast<int>(spec.numChannels);
+        maxDelaySamples = static_cast<int>(std::ceil(MaxDelaySeconds * sampleRate));
+        auto size = juce::nextPowerOfTwo(maxDelaySamples + static_cast<int>(spec.maximumBlockSize) + 1);
+        mask = size - 1;
+        ring.setSize(numChannels, size);
+        delayed.setSize(numChannels, static_cast<int>(spec.maximumBlockSize));
+        fading.setSize(numChannels, static_cast<int>(spec.maximumBlockSize));
+        feedbackBuffer.setSize(numChannels, static_cast<int>(spec.maximumBlockSize));
+        lowCutState.allocate(spec.numChannels, true);
+        highCutState.allocate(spec.numChannels, true);
+        crossfadeLength = juce::jmax(1, juce::roundToInt(CrossfadeSeconds * sampleRate));
+        lowCutHz = highCutHz = -1.f; //recompute both for the new rate
+        reset();
+    }
+
+    void reset()
+    {
+        ring.clear();
+        writeIndex = 0;
+        for (int ch = 0; ch < numChannels; ++ch)
+            lowCutState[ch] = highCutState[ch] = 0.f;
+        currentDelay = 0; //jumps straight to the first delay time set, without a crossfade
+        crossfadeRemaining = 0;
+    }
+
+    void setDelayMs(double ms)
+    {
+        targetDelay = juce::jlimit(1, juce::jmax(1, maxDelaySamples), juce::roundToInt(juce::jmax(static_cast<double>(MinDelayMs), ms) * sampleRate / 1000.0));
+    }
+
+    void setPingPong(bool shouldPingPong) { pingPong = shouldPingPong; }
+
+    //pairs every left channel with the first right one not yet taken, in channel order
+    void setChannelSides(const LaneSides& newSides)
+    {
+        sides = newSides;
+        partners.fill(-1);
+        for (size_t left = 0; left < sides.size(); ++left)
+        {
+            if (sides[left] != ChannelSide::Left)
+                continue;
+
+            for (size_t right = 0; right < sides.size(); ++right)
+            {
+                if (sides[right] == ChannelSide::Right && partners[right] < 0)
+                {
+                    partners[left] = static_cast<int>(right);
+                    partners[right] = static_cast<int>(left);
+                    break;
+                }
+            }
+        }
+    }
+
+    void setLowCutHz(float hz)
+    {
+        if (hz == lowCutHz)
+            return;
+        lowCutHz = hz;
+        lowCutCoefficient = hz <= MinLowCutHz ? 0.f : getOnePoleCoefficient(hz);
+    }
+
+    void setHighCutHz(float hz)
+    {
+        if (hz == highCutHz)
+            return;
+        highCutHz = hz;
+        highCutCoefficient = hz >= MaxHighCutHz ? 1.f : getOnePoleCoefficient(hz);
+    }
+
+    //replaces the block with the wet signal. feedbackPercent holds one value per sample of the block.
+    void process(const juce::dsp::AudioBlock<float>& block, const float* feedbackPercent)
+    {
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        if (currentDelay == 0)
+            currentDelay = targetDelay;
+        for (int start = 0; start < numSamples;)
+        {
+            if (crossfadeRemaining == 0 && targetDelay != currentDelay)
+            {
+                fadingDelay = currentDelay;
+                currentDelay = targetDelay;
+                crossfadeRemaining = crossfadeLength;
+            }
+            //a chunk never reads samples it is about to write
+            auto length = juce::jmin(numSamples - start, currentDelay);
+            if (crossfadeRemaining > 0)
+                length = juce::jmin(length, fadingDelay, crossfadeRemaining);
+            processChunk(block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(length)), feedbackPercent + start);
+            start += length;
+        }
+    }
+private:
+    double sampleRate = 44100.0;
+    int numChannels = 0, maxDelaySamples = 0, mask = 0, writeIndex = 0;
+    int currentDelay = 0, targetDelay = 1, fadingDelay = 1;
+    int crossfadeLength = 1, crossfadeRemaining = 0;
+    bool pingPong = false;
+    LaneSides sides {};
+    std::array<int, SIMDLanes::NumLanes> partners {}; //indexed by channel. The other channel of its ping-pong pair, or -1.
+    float lowCutHz = -1.f, highCutHz = -1.f;
+    float lowCutCoefficient = 0.f, highCutCoefficient = 1.f;
+    juce::AudioBuffer<float> ring, delayed, fading, feedbackBuffer;
+    juce::HeapBlock<float> lowCutState, highCutState;
+
+    float getOnePoleCoefficient(float hz) const
+    {
+        return 1.f - static_cast<float>(std::exp(-juce::MathConstants<double>::twoPi * hz / sampleRate));
+    }
+
+    void readFromRing(int channel, int delay, float* dest, int numSamples) const
+    {
+        auto start = (writeIndex - delay) & mask;
+        auto first = juce::jmin(numSamples, ring.getNumSamples() - start);
+        juce::FloatVectorOperations::copy(dest, ring.getReadPointer(channel, start), first);
+        if (first < numSamples)
+            juce::FloatVectorOperations::copy(dest + first, ring.getReadPointer(channel), numSamples - first);
+    }
+
+    void writeToRing(int channel, const float* source, int numSamples)
+    {
+        auto first = juce::jmin(numSamples, ring.getNumSamples() - writeIndex);
+        juce::FloatVectorOperations::copy(ring.getWritePointer(channel, writeIndex), source, first);
+        if (first < numSamples)
+            juce::FloatVectorOperations::copy(ring.getWritePointer(channel), source + first, numSamples - first);
+    }
+
+    void processChunk(const juce::dsp::AudioBlock<float>& block, const float* feedbackPercent)
+    {
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        const auto channels = juce::jmin(static_cast<int>(block.getNumChannels()), numChannels);
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            auto* wet = delayed.getWritePointer(ch);
+            readFromRing(ch, currentDelay, wet, numSamples);
+            if (crossfadeRemaining > 0)
+            {
+                auto* old = fading.getWritePointer(ch);
+                readFromRing(ch, fadingDelay, old, numSamples);
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    auto gain = static_cast<float>(crossfadeLength - crossfadeRemaining + i + 1) / static_cast<float>(crossfadeLength);
+                    wet[i] = old[i] + (wet[i] - old[i]) * gain;
+                }
+            }
+            //feedback = highcut(lowcut(wet)) * feedback
+            auto* fb = feedbackBuffer.getWritePointer(ch);
+            auto low = lowCutState[ch], high = highCutState[ch];
+            for (int i = 0; i < numSamples; ++i)
+            {
+                low += (wet[i] - low) * lowCutCoefficient;
+                high += (wet[i] - low - high) * highCutCoefficient;
+                fb[i] = high;
+            }
+            lowCutState[ch] = Denormals::flush(low);
+            highCutState[ch] = Denormals::flush(high);
+            juce::FloatVectorOperations::multiply(fb, feedbackPercent, numSamples);
+            juce::FloatVectorOperations::multiply(fb, 0.01f, numSamples);
+            //every trip round the loop shrinks the tail, so flush it before it goes back into the ring
+            Denormals::flush(fb, numSamples);
+        }
+        if (crossfadeRemaining > 0)
+            crossfadeRemaining -= numSamples;
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            const auto partner = pingPong ? partners[static_cast<size_t>(ch)] : -1;
+            if (partner < 0 || partner >= channels)
+            {
+                juce::FloatVectorOperations::add(feedbackBuffer.getWritePointer(ch), block.getChannelPointer(static_cast<size_t>(ch)), numSamples);
+                writeToRing(ch, feedbackBuffer.getReadPointer(ch), numSamples);
+            }
+            else if (sides[static_cast<size_t>(ch)] == ChannelSide::Left)
+            {
+                //left <- the pair's mono input + right feedback, right <- left feedback
+                auto* rightFeedback = feedbackBuffer.getWritePointer(partner);
+                juce::FloatVectorOperations::addWithMultiply(rightFeedback, block.getChannelPointer(static_cast<size_t>(ch)), 0.5f, numSamples);
+                juce::FloatVectorOperations::addWithMultiply(rightFeedback, block.getChannelPointer(static_cast<size_t>(partner)), 0.5f, numSamples);
+                writeToRing(ch, rightFeedback, numSamples);
+                writeToRing(partner, feedbackBuffer.getReadPointer(ch), numSamples);
+            }
+        }
+        for (int ch = 0; ch < channels; ++ch)
+            juce::FloatVectorOperations::copy(block.getChannelPointer(static_cast<size_t>(ch)), delayed.getReadPointer(ch), numSamples);
+        writeIndex = (writeIndex + numSamples) & mask;
+    }
+};
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    Denormals.h
+    Created: 24 Oct 2026 10:21:54am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Keeps feedback and filter state out of the denormal range without relying on the FPU's
+ flush-to-zero mode, which the host may not set and worker threads don't inherit.
+ Stages flush the state they carry from one sub-block to the next, and the samples they
+ write back into a feedback path. State they can't reach (juce's ladder and oversampling
+ filters) is kept normal by adding DCOffset to its input.
+ */
+namespace Denormals
+{
+//~-300 dB. Nothing this small is audible, and it is far above where floats go denormal.
+static constexpr float FlushThreshold = 1.0e-15f;
+
+//small enough to vanish under any signal, large enough to keep a filter's state normal forever
+static constexpr float DCOffset = 1.0e-18f;
+
+inline float flush(float x)
+{
+    return std::abs(x) < FlushThreshold ? 0.f : x;
+}
+
+inline double flush(double x)
+{
+    return std::abs(x) < static_cast<double>(FlushThreshold) ? 0.0 : x;
+}
+
+inline juce::dsp::SIMDRegister<float> flush(juce::dsp::SIMDRegister<float> x)
+{
+    using Register = juce::dsp::SIMDRegister<float>;
+    return x & Register::greaterThanOrEqual(Register::abs(x), Register::expand(FlushThreshold));
+}
+
+inline void flush(float* samples, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+        samples[i] = flush(samples[i]);
+}
+}
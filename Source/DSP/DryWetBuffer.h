@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    DryWetBuffer.h
+    Created: 21 Oct 2026 4:12:33pm
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Holds the dry copy of a block for something that processes it fully wet, and blends it
+ back in per sample from a mix ramp in percent. Each user has its own, so stages running
+ on parallel branches never share scratch memory.
+ */
+struct DryWetBuffer
+{
+    void prepare(int numChannels, int maxBlockSize)
+    {
+        dryBuffer.setSize(numChannels, maxBlockSize);
+        mixGains.allocate(static_cast<size_t>(maxBlockSize), true);
+    }
+
+    void pushDry(const juce::dsp::AudioBlock<float>& block)
+    {
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+            dryBuffer.copyFrom(static_cast<int>(ch), 0, block.getChannelPointer(ch), numSamples);
+    }
+
+    //the copy made by the last pushDry(), e.g. to delay it in line with a wet path that has latency
+    juce::dsp::AudioBlock<float> getDryBlock(size_t numChannels, size_t numSamples)
+    {
+        return juce::dsp::AudioBlock<float>(dryBuffer).getSubsetChannelBlock(0, numChannels).getSubBlock(0, numSamples);
+    }
+
+    void mixWet(const juce::dsp::AudioBlock<float>& block, const float* mixPercent)
+    {
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        juce::FloatVectorOperations::copyWithMultiply(mixGains.get(), mixPercent, 0.01f, numSamples);
+
+        //out = dry + (wet - dry) * mix
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+        {
+            auto* wet = block.getChannelPointer(ch);
+            auto* dry = dryBuffer.getReadPointer(static_cast<int>(ch));
+            juce::FloatVectorOperations::subtract(wet, dry, numSamples);
+            juce::FloatVectorOperations::multiply(wet, mixGains.get(), numSamples);
+            juce::FloatVectorOperations::add(wet, dry, numSamples);
+        }
+    }
+private:
+    juce::AudioBuffer<float> dryBuffer;
+    juce::HeapBlock<float> mixGains;
+};
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    LevelDetector.h
+    Created: 26 Oct 2026 9:48:12am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Peak and RMS of every channel in one SIMD pass over the samples. A block can be measured
+ in pieces (the modulation grid splits it at sub-block boundaries) and the pieces add up
+ to the whole block, so the meters, the sleep check and the envelope follower all read
+ the same single scan instead of each walking the buffer again.
+ */
+struct LevelDetector
+{
+    struct Levels
+    {
+        float peak = 0.f;
+        double sumOfSquares = 0.0;
+        int numSamples = 0;
+
+        float getRMS() const { return numSamples > 0 ? static_cast<float>(std::sqrt(sumOfSquares / numSamples)) : 0.f; }
+
+        void merge(const Levels& other)
+        {
+            peak = juce::jmax(peak, other.peak);
+            sumOfSquares += other.sumOfSquares;
+            numSamples += other.numSamples;
+        }
+    };
+
+    //abs/max and square/add in the same loop. The unaligned head and tail are done one sample at a time.
+    static Levels measure(const float* samples, int numSamples)
+    {
+        using Register = juce::dsp::SIMDRegister<float>;
+
+        const auto* end = samples + numSamples;
+        const auto* aligned = juce::jmin<const float*>(Register::getNextSIMDAlignedPtr(const_cast<float*>(samples)), end);
+        const auto numRegisters = static_cast<size_t>(end - aligned) / Register::SIMDNumElements;
+        const auto* alignedEnd = aligned + numRegisters * Register::SIMDNumElements;
+
+        float peak = 0.f, sumOfSquares = 0.f;
+        auto measureScalar = [&](const float* from, const float* to)
+        {
+            for (; from < to; ++from)
+            {
+                peak = juce::jmax(peak, std::abs(*from));
+                sumOfSquares += *from * *from;
+            }
+        };
+
+        measureScalar(samples, aligned);
+
+        auto peaks = Register::expand(0.f), squares = Register::expand(0.f);
+        for (const auto* x = aligned; x < alignedEnd; x += Register::SIMDNumElements)
+        {
+            auto value = Register::fromRawArray(x);
+            peaks = Register::max(peaks, Register::abs(value));
+            squares += value * value;
+        }
+
+        for (size_t i = 0; i < Register::SIMDNumElements; ++i)
+            peak = juce::jmax(peak, peaks.get(i));
+        sumOfSquares += squares.sum();
+
+        measureScalar(alignedEnd, end);
+
+        return { peak, static_cast<double>(sumOfSquares), numSamples };
+    }
+
+    void prepare(int maxChannels)
+    {
+        blockLevels.resize(static_cast<size_t>(maxChannels));
+        beginBlock();
+    }
+
+    void beginBlock() { std::fill(blockLevels.begin(), blockLevels.end(), Levels {}); }
+
+    //measures samples start...start + length of every channel, adds them to the block and returns the loudest peak
+    float measure(const juce::AudioBuffer<float>& buffer, int start, int length)
+    {
+        const auto numChannels = juce::jmin(buffer.getNumChannels(), static_cast<int>(blockLevels.size()));
+
+        float peak = 0.f;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto levels = measure(buffer.getReadPointer(ch, start), length);
+            blockLevels[static_cast<size_t>(ch)].merge(levels);
+            peak = juce::jmax(peak, levels.peak);
+        }
+
+        return peak;
+    }
+
+    const Levels& getLevels(int channel) const { return blockLevels[static_cast<size_t>(channel)]; }
+
+    float getPeak() const
+    {
+        float peak = 0.f;
+        for (const auto& levels : blockLevels)
+            peak = juce::jmax(peak, levels.peak);
+        return peak;
+    }
+private:
+    std::vector<Levels> blockLevels;
+};
@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    LockFreeQueue.h
+    Created: 24 Oct 2026 2:48:17pm
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <type_traits>
+
+/*
+ Bounded multi-producer, multi-consumer queue of trivially copyable items. Every slot
+ carries a sequence number telling producers and consumers whose turn it is, so neither
+ side ever locks or allocates, and a full or empty queue is reported instead of waited on.
+ */
+template <typename T, size_t Capacity>
+struct LockFreeQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "items are copied in and out of the slots");
+
+    LockFreeQueue()
+    {
+        for (size_t i = 0; i < Capacity; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    //returns false if the queue is full
+    bool push(const T& item)
+    {
+        auto position = pushPosition.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& cell = cells[position & Mask];
+            auto sequence = cell.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+            if (difference == 0)
+            {
+                if (pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.item = item;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = pushPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //returns false if the queue is empty
+    bool pop(T& item)
+    {
+        auto position = popPosition.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& cell = cells[position & Mask];
+            auto sequence = cell.sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+            if (difference == 0)
+            {
+                if (popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    item = cell.item;
+                    cell.sequence.store(position + Capacity, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = popPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //for producers that must not fail, e.g. the audio thread reporting to a UI that may not be draining.
+    //Drops the oldest items to make room, so a consumer that comes back late still sees the newest ones.
+    void pushDroppingOldest(const T& item)
+    {
+        T dropped;
+        while (push(item) == false)
+            pop(dropped);
+    }
+private:
+    static constexpr size_t Mask = Capacity - 1;
+    struct Cell
+    {
+        std::atomic<size_t> sequence {0};
+        T item {};
+    };
+    std::array<Cell, Capacity> cells;
+    alignas(64) std::atomic<size_t> pushPosition {0};
+    alignas(64) std::atomic<size_t> popPosition {0};
+
+    JUCE_DECLARE_NON_COPYABLE(LockFreeQueue)
+};
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    ModulationMatrix.h
+    Created: 25 Oct 2026 11:41:09am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ModulationSources.h"
+
+/*
+ Sparse routing from ModulationSources to NumDestinations destinations. Only the routes in
+ use are stored, in a fixed table of MaxRoutes, and only destinations with a route get a row
+ of amounts, so an empty matrix costs nothing and adding routes never allocates.
+ A destination's amount is the sum of depth * source over its routes, per sample.
+ */
+template <size_t MaxRoutes, size_t NumDestinations>
+struct ModulationMatrix
+{
+    void prepare(int maxBlockSize)
+    {
+        amounts.setSize(static_cast<int>(MaxRoutes), maxBlockSize);
+        clearRoutes();
+    }
+
+    void clearRoutes()
+    {
+        numRoutes = 0;
+        rowForDestination.fill(-1);
+    }
+
+    //returns false if the table is full or the route does nothing
+    bool addRoute(ModulationSources::Source source, size_t destination, float depth)
+    {
+        if (numRoutes == MaxRoutes || destination >= NumDestinations || depth == 0.f)
+            return false;
+
+        routes[numRoutes++] = { source, destination, depth };
+        return true;
+    }
+
+    void process(const ModulationSources& sources, int numSamples)
+    {
+        rowForDestination.fill(-1);
+        int numRows = 0;
+
+        for (size_t i = 0; i < numRoutes; ++i)
+        {
+            const auto& route = routes[i];
+            auto& row = rowForDestination[route.destination];
+            if (row < 0)
+            {
+                row = numRows++;
+                juce::FloatVectorOperations::clear(amounts.getWritePointer(row), numSamples);
+            }
+
+            juce::FloatVectorOperations::addWithMultiply(amounts.getWritePointer(row), sources.getRamp(route.source), route.depth, numSamples);
+        }
+    }
+
+    //nullptr if nothing modulates the destination
+    const float* getAmounts(size_t destination) const
+    {
+        auto row = rowForDestination[destination];
+        return row < 0 ? nullptr : amounts.getReadPointer(row);
+    }
+private:
+    struct Route
+    {
+        ModulationSources::Source source = ModulationSources::LFO1;
+        size_t destination = 0;
+        float depth = 0.f;
+    };
+
+    std::array<Route, MaxRoutes> routes;
+    size_t numRoutes = 0;
+    std::array<int, NumDestinations> rowForDestination;
+    juce::AudioBuffer<float> amounts;
+};
@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    ModulationSources.h
+    Created: 25 Oct 2026 11:03:26am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Denormals.h"
+
+/*
+ Two LFOs, an envelope follower and a step sequencer.
+ Every source ticks once per sub-block, on multiples of the sub-block size along the
+ processor's sample timeline, and ramps from its previous value to the new one over the
+ sub-block after the tick. A tick only looks at what came before it, so the ramps are
+ the same however the host splits its blocks.
+ The LFOs and the sequencer are bipolar (-1...1). The envelope is unipolar (0...1).
+ */
+struct ModulationSources
+{
+    enum Source
+    {
+        LFO1,
+        LFO2,
+        Envelope,
+        Sequencer,
+        NumSources
+    };
+
+    enum class Shape
+    {
+        Sine,
+        Triangle,
+        Saw,
+        Square,
+        Random,
+    };
+
+    static constexpr size_t NumLFOs = 2;
+    static constexpr size_t NumSteps = 8;
+
+    //index 0 is "None", index n is Source n - 1
+    static juce::StringArray getSourceChoices() { return { "None", "LFO 1", "LFO 2", "Envelope", "Sequencer" }; }
+    static juce::StringArray getShapeChoices() { return { "Sine", "Triangle", "Saw", "Square", "Random" }; }
+
+    struct Settings
+    {
+        std::array<float, NumLFOs> lfoRateHz {};
+        std::array<Shape, NumLFOs> lfoShape {};
+        float envelopeAttackMs = 0.f, envelopeReleaseMs = 0.f;
+        float sequencerRateHz = 0.f; //steps per second
+        std::array<float, NumSteps> steps {};
+    };
+
+    void prepare(double newSampleRate, int maxBlockSize)
+    {
+        sampleRate = newSampleRate;
+        ramps.setSize(NumSources, maxBlockSize);
+        reset();
+    }
+
+    void reset()
+    {
+        lfoPhase.fill(0.f);
+        randomValue.fill(0.f);
+        random.setSeed(RandomSeed);
+        envelope = 0.f;
+        subBlockPeak = 0.f;
+        sequencerPhase = 0.f;
+        previous.fill(0.f);
+        current.fill(0.f);
+    }
+
+    //fills every source's ramp for numSamples starting at position. The envelope follows
+    //measurePeak(start, length), the peak of the input over that piece of the block.
+    template <typename MeasurePeak>
+    void process(juce::int64 position, int numSamples, int subBlockSize, const Settings& settings, MeasurePeak&& measurePeak)
+    {
+        jassert(numSamples <= ramps.getNumSamples() && subBlockSize > 0);
+        numSamples = juce::jmin(numSamples, ramps.getNumSamples());
+
+        for (int start = 0, length = 0; start < numSamples; start += length)
+        {
+            auto intoSubBlock = static_cast<int>((position + start) % subBlockSize);
+            length = juce::jmin(numSamples - start, subBlockSize - intoSubBlock);
+
+            if (intoSubBlock == 0)
+                tick(settings, subBlockSize);
+
+            //the envelope ticks on the peak of the whole sub-block, which may arrive in pieces
+            subBlockPeak = juce::jmax(subBlockPeak, measurePeak(start, length));
+
+            for (size_t s = 0; s < NumSources; ++s)
+            {
+                auto* ramp = ramps.getWritePointer(static_cast<int>(s), start);
+                auto increment = (current[s] - previous[s]) / static_cast<float>(subBlockSize);
+                for (int i = 0; i < length; ++i)
+                    ramp[i] = previous[s] + increment * static_cast<float>(intoSubBlock + i);
+            }
+        }
+    }
+
+    const float* getRamp(Source source) const { return ramps.getReadPointer(static_cast<int>(source)); }
+private:
+    static constexpr juce::int64 RandomSeed = 0x6d6f64; //fixed, so renders repeat
+
+    void tick(const Settings& settings, int subBlockSize)
+    {
+        previous = current;
+        const auto seconds = static_cast<float>(subBlockSize / sampleRate);
+
+        for (size_t i = 0; i < NumLFOs; ++i)
+        {
+            current[LFO1 + i] = getLFOValue(i, settings.lfoShape[i]);
+
+            lfoPhase[i] += settings.lfoRateHz[i] * seconds;
+            if (lfoPhase[i] >= 1.f)
+            {
+                lfoPhase[i] -= std::floor(lfoPhase[i]);
+                randomValue[i] = random.nextFloat() * 2.f - 1.f;
+            }
+        }
+
+        //one pole on the sub-block peaks, per sub-block instead of per sample
+        auto timeMs = subBlockPeak > envelope ? settings.envelopeAttackMs : settings.envelopeReleaseMs;
+        auto coefficient = timeMs > 0.f ? std::exp(-1000.f * seconds / timeMs) : 0.f;
+        envelope = Denormals::flush(subBlockPeak + coefficient * (envelope - subBlockPeak));
+        current[Envelope] = juce::jlimit(0.f, 1.f, envelope);
+        subBlockPeak = 0.f;
+
+        auto step = juce::jmin(NumSteps - 1, static_cast<size_t>(sequencerPhase * static_cast<float>(NumSteps)));
+        current[Sequencer] = settings.steps[step];
+        sequencerPhase += settings.sequencerRateHz * seconds / static_cast<float>(NumSteps);
+        sequencerPhase -= std::floor(sequencerPhase);
+    }
+
+    float getLFOValue(size_t lfo, Shape shape) const
+    {
+        auto phase = lfoPhase[lfo];
+        switch (shape)
+        {
+            case Shape::Sine:     return std::sin(juce::MathConstants<float>::twoPi * phase);
+            case Shape::Triangle: return 1.f - 4.f * std::abs(phase - 0.5f);
+            case Shape::Saw:      return 2.f * phase - 1.f;
+            case Shape::Square:   return phase < 0.5f ? 1.f : -1.f;
+            case Shape::Random:   return randomValue[lfo];
+        }
+        return 0.f;
+    }
+
+    double sampleRate = 44100.0;
+    juce::AudioBuffer<float> ramps;
+    std::array<float, NumSources> previous {}, current {};
+    std::array<float, NumLFOs> lfoPhase {}, randomValue {};
+    juce::Random random;
+    float envelope = 0.f, subBlockPeak = 0.f;
+    float sequencerPhase = 0.f;
+};
@@ -0,0 +1,293 @@
+/*
+  ==============================================================================
+
+    OutputMeter.h
+    Created: 26 Oct 2026 1:37:08pm
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Denormals.h"
+
+/*
+ Everything the Out meters show, measured in one pass per channel over the block: RMS,
+ sample peak, true peak from 4x polyphase interpolation, and ITU-R BS.1770 K-weighted
+ loudness. The K-weighted power is summed in 100 ms bins. Momentary loudness is the last
+ 4 bins (400 ms) and short-term the last 30 (3 s), per channel and for the whole bus with
+ the BS.1770 channel weights. Nothing allocates, so it runs on the audio thread.
+ */
+template <size_t MaxChannels>
+struct OutputMeter
+{
+    static constexpr float MinLufs = -100.f; //reported for silence
+    static constexpr size_t MomentaryBins = 4, ShortTermBins = 30;
+
+    struct ChannelReadings
+    {
+        float rms = 0.f, peak = 0.f, truePeak = 0.f;
+        float momentaryLufs = MinLufs, shortTermLufs = MinLufs;
+    };
+
+    struct Readings
+    {
+        std::array<ChannelReadings, MaxChannels> channels {};
+        float momentaryLufs = MinLufs, shortTermLufs = MinLufs;
+    };
+
+    //the weight of each channel in the bus's loudness: 1 for front, 1.41 for side surround, 0 for LFE
+    void prepare(double sampleRate, const std::array<float, MaxChannels>& channelWeights)
+    {
+        weights = channelWeights;
+        binLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+        designKWeighting(sampleRate);
+        designInterpolator();
+        reset();
+    }
+
+    void reset()
+    {
+        for (auto& state : states)
+            state = {};
+
+        binFill = 0;
+        binIndex = 0;
+        readings = {};
+    }
+
+    //measures the first numChannels channels of buffer. The loudness readings move on every 100 ms.
+    const Readings& process(const juce::AudioBuffer<float>& buffer, int numChannels)
+    {
+        numChannels = juce::jmin(numChannels, buffer.getNumChannels(), static_cast<int>(MaxChannels));
+        const auto numSamples = buffer.getNumSamples();
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& state = states[static_cast<size_t>(ch)];
+            state.peak = state.truePeak = 0.f;
+            state.sumOfSquares = 0.0;
+        }
+
+        //split at the bin boundaries so every piece adds to a single bin
+        for (int start = 0, length = 0; start < numSamples; start += length)
+        {
+            length = juce::jmin(numSamples - start, binLength - binFill);
+            for (int ch = 0; ch < numChannels; ++ch)
+                measure(states[static_cast<size_t>(ch)], buffer.getReadPointer(ch, start), length);
+
+            binFill += length;
+            if (binFill == binLength)
+                closeBin(numChannels);
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto& state = states[static_cast<size_t>(ch)];
+            auto& channel = readings.channels[static_cast<size_t>(ch)];
+            channel.rms = numSamples > 0 ? static_cast<float>(std::sqrt(state.sumOfSquares / numSamples)) : 0.f;
+            channel.peak = state.peak;
+            channel.truePeak = juce::jmax(state.peak, state.truePeak);
+        }
+
+        return readings;
+    }
+
+    //moves the loudness windows on over numSamples of silence without reading any samples
+    const Readings& skipSilence(int numSamples, int numChannels)
+    {
+        numChannels = juce::jmin(numChannels, static_cast<int>(MaxChannels));
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& state = states[static_cast<size_t>(ch)];
+            state.shelf = state.highPass = {};
+            state.history = {};
+            state.binSum = 0.0;
+
+            auto& channel = readings.channels[static_cast<size_t>(ch)];
+            channel.rms = channel.peak = channel.truePeak = 0.f;
+        }
+
+        while (numSamples > 0)
+        {
+            auto length = juce::jmin(numSamples, binLength - binFill);
+            binFill += length;
+            numSamples -= length;
+            if (binFill == binLength)
+                closeBin(numChannels);
+        }
+
+        return readings;
+    }
+
+    float getPeak(int numChannels) const
+    {
+        float peak = 0.f;
+        for (int ch = 0; ch < juce::jmin(numChannels, static_cast<int>(MaxChannels)); ++ch)
+            peak = juce::jmax(peak, readings.channels[static_cast<size_t>(ch)].peak);
+        return peak;
+    }
+private:
+    static constexpr size_t Phases = 4, TapsPerPhase = 12;
+
+    //transposed direct form II, in double: the 38 Hz high-pass has poles too close to 1 for float
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    struct ChannelState
+    {
+        std::array<double, 2> shelf {}, highPass {};
+        //every sample is written twice, so the last TapsPerPhase samples are always contiguous
+        std::array<float, TapsPerPhase * 2> history {};
+        size_t historyIndex = 0;
+        double binSum = 0.0;
+        std::array<double, ShortTermBins> bins {};
+        float peak = 0.f, truePeak = 0.f;
+        double sumOfSquares = 0.0;
+    };
+
+    static double runBiquad(const Biquad& f, std::array<double, 2>& z, double x)
+    {
+        auto y = f.b0 * x + z[0];
+        z[0] = f.b1 * x - f.a1 * y + z[1];
+        z[1] = f.b2 * x - f.a2 * y;
+        return y;
+    }
+
+    //peak, sum of squares, true peak and K-weighted power of one channel, all in the same loop
+    void measure(ChannelState& state, const float* samples, int numSamples)
+    {
+        auto peak = state.peak, truePeak = state.truePeak;
+        auto sumOfSquares = 0.0, binSum = 0.0;
+        auto index = state.historyIndex;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto x = samples[i];
+            peak = juce::jmax(peak, std::abs(x));
+            sumOfSquares += static_cast<double>(x * x);
+
+            state.history[index] = state.history[index + TapsPerPhase] = x;
+            const auto* window = state.history.data() + index + 1;
+            index = index + 1 == TapsPerPhase ? 0 : index + 1;
+
+            for (const auto& phase : interpolator)
+            {
+                float y = 0.f;
+                for (size_t k = 0; k < TapsPerPhase; ++k)
+                    y += phase[k] * window[k];
+                truePeak = juce::jmax(truePeak, std::abs(y));
+            }
+
+            auto weighted = runBiquad(highPass, state.highPass, runBiquad(shelf, state.shelf, static_cast<double>(x)));
+            binSum += weighted * weighted;
+        }
+
+        for (auto* z : { &state.shelf, &state.highPass })
+            for (auto& value : *z)
+                value = Denormals::flush(value);
+
+        state.peak = peak;
+        state.truePeak = truePeak;
+        state.sumOfSquares += sumOfSquares;
+        state.binSum += binSum;
+        state.historyIndex = index;
+    }
+
+    static float toLufs(double meanSquare)
+    {
+        return meanSquare > 0.0 ? juce::jmax(MinLufs, static_cast<float>(-0.691 + 10.0 * std::log10(meanSquare))) : MinLufs;
+    }
+
+    void closeBin(int numChannels)
+    {
+        binIndex = (binIndex + 1) % ShortTermBins;
+        binFill = 0;
+
+        double momentary = 0.0, shortTerm = 0.0;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& state = states[static_cast<size_t>(ch)];
+            state.bins[binIndex] = state.binSum / binLength;
+            state.binSum = 0.0;
+
+            double channelMomentary = 0.0, channelShortTerm = 0.0;
+            for (size_t i = 0; i < ShortTermBins; ++i)
+            {
+                auto power = state.bins[(binIndex + ShortTermBins - i) % ShortTermBins];
+                channelShortTerm += power;
+                if (i < MomentaryBins)
+                    channelMomentary += power;
+            }
+
+            channelMomentary /= static_cast<double>(MomentaryBins);
+            channelShortTerm /= static_cast<double>(ShortTermBins);
+
+            auto& channel = readings.channels[static_cast<size_t>(ch)];
+            channel.momentaryLufs = toLufs(channelMomentary);
+            channel.shortTermLufs = toLufs(channelShortTerm);
+
+            momentary += weights[static_cast<size_t>(ch)] * channelMomentary;
+            shortTerm += weights[static_cast<size_t>(ch)] * channelShortTerm;
+        }
+
+        readings.momentaryLufs = toLufs(momentary);
+        readings.shortTermLufs = toLufs(shortTerm);
+    }
+
+    //BS.1770's two stages (high shelf, then high-pass), derived for any sample rate as libebur128 does
+    void designKWeighting(double sampleRate)
+    {
+        auto k = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+        auto q = 0.7071752369554196;
+        auto vh = std::pow(10.0, 3.999843853973347 / 20.0);
+        auto vb = std::pow(vh, 0.4996667741545416);
+        auto a0 = 1.0 + k / q + k * k;
+        shelf = { (vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                  2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+
+        k = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+        q = 0.5003270373238773;
+        a0 = 1.0 + k / q + k * k;
+        highPass = { 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+    }
+
+    //48 tap windowed sinc cut at the original Nyquist, split into 4 phases of 12. Each phase is
+    //stored oldest sample first to match the history window, and scaled to unity gain at DC.
+    void designInterpolator()
+    {
+        constexpr auto numTaps = Phases * TapsPerPhase;
+        constexpr auto centre = (static_cast<double>(numTaps) - 1.0) / 2.0;
+
+        for (size_t p = 0; p < Phases; ++p)
+        {
+            std::array<double, TapsPerPhase> taps {};
+            double sum = 0.0;
+            for (size_t k = 0; k < TapsPerPhase; ++k)
+            {
+                auto tap = (TapsPerPhase - 1 - k) * Phases + p;
+                auto t = (static_cast<double>(tap) - centre) / static_cast<double>(Phases);
+                auto sinc = t == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::pi * t) / (juce::MathConstants<double>::pi * t);
+                auto w = juce::MathConstants<double>::twoPi * static_cast<double>(tap) / static_cast<double>(numTaps - 1);
+                auto blackman = 0.42 - 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w);
+                taps[k] = sinc * blackman;
+                sum += taps[k];
+            }
+
+            for (size_t k = 0; k < TapsPerPhase; ++k)
+                interpolator[p][k] = static_cast<float>(taps[k] / sum);
+        }
+    }
+
+    std::array<float, MaxChannels> weights {};
+    Biquad shelf, highPass;
+    std::array<std::array<float, TapsPerPhase>, Phases> interpolator {};
+    std::array<ChannelState, MaxChannels> states {};
+    int binLength = 4800, binFill = 0;
+    size_t binIndex = 0;
+    Readings readings;
+};
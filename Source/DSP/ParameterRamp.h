@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    ParameterRamp.h
+    Created: 18 Oct 2026 10:07:51am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ One value per sample for a smoothed parameter over the current block.
+ Filled once per block, so per-sample consumers (gain, mix, drive) just read it and
+ control-rate consumers sample it at their sub-block start.
+ */
+struct ParameterRamp
+{
+    //indices must hold 1, 2, 3 ... maxNumSamples. It is shared by every ramp.
+    void prepare(int maxNumSamples, const float* indices)
+    {
+        data.allocate(static_cast<size_t>(maxNumSamples), true);
+        capacity = maxNumSamples;
+        indexRamp = indices;
+        filledConstant = false;
+    }
+
+    void fill(float startValue, float endValue, int numSamples)
+    {
+        jassert(numSamples <= capacity);
+        numSamples = juce::jmin(numSamples, capacity);
+        if (numSamples <= 0)
+            return;
+
+        if (startValue == endValue)
+        {
+            //nothing to redo if the buffer already holds this value
+            if (filledConstant == false || constantValue != endValue || filledLength < numSamples)
+            {
+                juce::FloatVectorOperations::fill(data.get(), endValue, numSamples);
+                filledLength = numSamples;
+            }
+
+            filledConstant = true;
+            constantValue = endValue;
+            return;
+        }
+
+        const auto increment = (endValue - startValue) / static_cast<float>(numSamples);
+        juce::FloatVectorOperations::copyWithMultiply(data.get(), indexRamp, increment, numSamples);
+        juce::FloatVectorOperations::add(data.get(), startValue, numSamples);
+        data[numSamples - 1] = endValue;
+
+        filledConstant = false;
+        filledLength = numSamples;
+    }
+
+    //the smoother's own per-sample path, for while it is moving. Unlike a straight line from the
+    //value before the block to the value after, it doesn't depend on where the block starts and ends.
+    //Each value is passed through convert(), e.g. to turn decibels into gain.
+    template <typename Smoother, typename Convert>
+    void fillFrom(Smoother& smoother, int numSamples, Convert&& convert)
+    {
+        jassert(numSamples <= capacity);
+        numSamples = juce::jmin(numSamples, capacity);
+        if (numSamples <= 0)
+            return;
+
+        for (int i = 0; i < numSamples; ++i)
+            data[i] = convert(smoother.getNextValue());
+
+        filledConstant = false;
+        filledLength = numSamples;
+    }
+
+    //rewrites the first numSamples values as fn(value, sampleIndex), e.g. to apply modulation
+    template <typename Fn>
+    void transform(int numSamples, Fn&& fn)
+    {
+        numSamples = juce::jmin(numSamples, filledLength);
+        for (int i = 0; i < numSamples; ++i)
+            data[i] = fn(data[i], i);
+
+        filledConstant = false;
+    }
+
+    bool isConstant() const { return filledConstant; }
+    const float* get(size_t startSample = 0) const { return data.get() + startSample; }
+    float operator[](size_t index) const { return data[index]; }
+
+private:
+    juce::HeapBlock<float> data;
+    const float* indexRamp = nullptr;
+    int capacity = 0, filledLength = 0;
+    bool filledConstant = false;
+    float constantValue = 0.f;
+};
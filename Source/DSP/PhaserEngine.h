@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    PhaserEngine.h
+    Created: 20 Oct 2026 5:14:48pm
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDLanes.h"
+#include "SineLFO.h"
+#include "Denormals.h"
+#include "ChannelSide.h"
+
+/*
+ Drop-in for juce::dsp::Phaser<float> at mix 1, running every channel as a lane of an
+ interleaved SIMDLanes block. Like juce's phaser the LFO runs at a quarter of the sample
+ rate, but the allpass coefficient is computed once per update and shared by all six
+ stages and every channel instead of being recomputed by each filter. The LFE passes through dry.
+ */
+struct PhaserEngine
+{
+    using Register = SIMDLanes::Register;
+
+    static constexpr size_t NumStages = 6;
+    static constexpr int UpdateInterval = 4;
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        maxFrequency = static_cast<float>(juce::jmin(20000.0, 0.49 * sampleRate));
+        lfo.prepare(sampleRate / UpdateInterval);
+        setCentreFrequency(centreFrequency);
+        setAllpassFrequency(1000.f);
+        update();
+        reset();
+    }
+
+    void reset()
+    {
+        lastOutput = Register::expand(0.f);
+        state.fill(Register::expand(0.f));
+        lfo.reset();
+        oscVolume.reset(sampleRate / UpdateInterval, 0.05);
+        feedbackVolume.reset(sampleRate, 0.05);
+        updateCounter = 0;
+    }
+
+    void setRate(float hz) { rate = hz; update(); }
+    void setDepth(float newDepth) { depth = juce::jlimit(0.f, 1.f, newDepth); update(); }
+    void setFeedback(float newFeedback) { feedback = juce::jlimit(-1.f, 1.f, newFeedback); update(); }
+
+    void setCentreFrequency(float hz)
+    {
+        centreFrequency = hz;
+        normCentreFrequency = juce::mapFromLog10(juce::jlimit(MinFrequency, maxFrequency, hz), MinFrequency, maxFrequency);
+    }
+
+    //the side of each lane's channel, from the bus layout. Only the LFE is treated differently.
+    void setChannelSides(const LaneSides& sides)
+    {
+        for (size_t lane = 0; lane < SIMDLanes::NumLanes; ++lane)
+        {
+            wetLanes.set(lane, sides[lane] == ChannelSide::LFE ? 0.f : 1.f);
+            dryLanes.set(lane, sides[lane] == ChannelSide::LFE ? 1.f : 0.f);
+        }
+    }
+
+    void process(const juce::dsp::AudioBlock<Register>& block)
+    {
+        auto* samples = block.getChannelPointer(0);
+        const auto numSamples = block.getNumSamples();
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            if (updateCounter == 0)
+            {
+                auto lfoValue = lfo.processSample() * oscVolume.getNextValue();
+                auto normFrequency = juce::jlimit(0.f, 1.f, lfoValue + normCentreFrequency);
+                setAllpassFrequency(juce::mapToLog10(normFrequency, MinFrequency, maxFrequency));
+            }
+            if (++updateCounter == UpdateInterval)
+                updateCounter = 0;
+            //six first order TPT allpasses in series
+            const auto input = samples[i];
+            auto x = input - lastOutput;
+            for (auto& s : state)
+            {
+                auto v = (x - s) * G;
+                auto y = v + s;
+                s = y + v;
+                x = y * 2.f - x;
+            }
+            samples[i] = x * wetLanes + input * dryLanes;
+            lastOutput = x * feedbackVolume.getNextValue();
+        }
+        //the allpass states ring on with feedback after the input stops
+        lastOutput = Denormals::flush(lastOutput);
+        for (auto& s : state)
+            s = Denormals::flush(s);
+    }
+private:
+    static constexpr float MinFrequency = 20.f;
+    double sampleRate = 44100.0;
+    float rate = 1.f, depth = 0.5f, feedback = 0.f, centreFrequency = 1300.f; //juce::dsp::Phaser defaults
+    float normCentreFrequency = 0.5f, maxFrequency = 20000.f, G = 0.f;
+    int updateCounter = 0;
+    SineLFO lfo;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> oscVolume, feedbackVolume;
+    std::array<Register, NumStages> state;
+    Register lastOutput;
+    Register wetLanes = Register::expand(1.f), dryLanes = Register::expand(0.f); //1 and 0 per lane, swapped for the LFE
+
+    void update()
+    {
+        lfo.setFrequency(rate);
+        oscVolume.setTargetValue(depth * 0.5f);
+        feedbackVolume.setTargetValue(feedback);
+    }
+
+    void setAllpassFrequency(float hz)
+    {
+        auto g = static_cast<float>(std::tan(juce::MathConstants<double>::pi * hz / sampleRate));
+        G = g / (1.f + g);
+    }
+};
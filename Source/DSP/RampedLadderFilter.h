@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    RampedLadderFilter.h
+    Created: 18 Oct 2026 10:52:13am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Denormals.h"
+
+/*
+ juce::dsp::LadderFilter that takes its drive from a per-sample ramp instead of a value
+ set once per sub-block. setDrive() is only re-run when the ramp value actually changes.
+ When oversampled, each drive value covers 2^oversamplingOrder samples.
+ LadderFilter's state is private, so Denormals::DCOffset on the input keeps it from decaying into denormals.
+ */
+struct RampedLadderFilter : juce::dsp::LadderFilter<float>
+{
+    void processWithDrive(const juce::dsp::ProcessContextReplacing<float>& context, const float* drive, size_t oversamplingOrder = 0)
+    {
+        if (context.isBypassed)
+            return;
+
+        auto& block = context.getOutputBlock();
+        const auto numChannels = block.getNumChannels();
+        const auto numSamples = block.getNumSamples();
+        jassert(numChannels <= getNumChannels());
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto newDrive = drive[i >> oversamplingOrder];
+            if (newDrive != currentDrive)
+            {
+                currentDrive = newDrive;
+                setDrive(currentDrive);
+            }
+
+            updateSmoothers();
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                auto* samples = block.getChannelPointer(ch);
+                samples[i] = processSample(samples[i] + Denormals::DCOffset, ch);
+            }
+        }
+    }
+
+private:
+    float currentDrive = 1.f; //LadderFilter's default drive
+};
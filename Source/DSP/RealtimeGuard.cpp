@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.cpp
+    Created: 17 Oct 2026 9:41:12am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#include "RealtimeGuard.h"
+
+#if P13_TRAP_REALTIME_ALLOCATIONS
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+//the depth is per-thread so the message thread can keep allocating while processBlock runs.
+thread_local int noAllocationDepth = 0;
+
+void checkAllocationAllowed()
+{
+    if (noAllocationDepth > 0)
+    {
+        //jassert may allocate when logging, so allow it for the duration of the report.
+        RealtimeGuard::ScopedAllowAllocation allow;
+        jassertfalse; //something allocated on the audio thread. Check the call stack.
+    }
+}
+
+void* allocateChecked(std::size_t size)
+{
+    checkAllocationAllowed();
+
+    if (auto ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+//over-aligned types (e.g. SIMDRegister members under AVX) come here. std::aligned_alloc isn't
+//available everywhere, so over-allocate and keep the malloc'd pointer just before the aligned block.
+void* allocateAlignedChecked(std::size_t size, std::align_val_t alignment)
+{
+    checkAllocationAllowed();
+
+    const auto align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+    auto* raw = static_cast<char*>(std::malloc(size + align + sizeof(void*)));
+    if (raw == nullptr)
+        throw std::bad_alloc();
+
+    auto aligned = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*) + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1);
+    reinterpret_cast<void**>(aligned)[-1] = raw;
+    return reinterpret_cast<void*>(aligned);
+}
+
+void freeAligned(void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        std::free(static_cast<void**>(ptr)[-1]);
+}
+}
+
+void* operator new (std::size_t size) { return allocateChecked(size); }
+void* operator new[] (std::size_t size) { return allocateChecked(size); }
+void operator delete (void* ptr) noexcept { std::free(ptr); }
+void operator delete[] (void* ptr) noexcept { std::free(ptr); }
+void operator delete (void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void* operator new (std::size_t size, std::align_val_t alignment) { return allocateAlignedChecked(size, alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment) { return allocateAlignedChecked(size, alignment); }
+void operator delete (void* ptr, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete[] (void* ptr, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete (void* ptr, std::size_t, std::align_val_t) noexcept { freeAligned(ptr); }
+void operator delete[] (void* ptr, std::size_t, std::align_val_t) noexcept { freeAligned(ptr); }
+
+namespace RealtimeGuard
+{
+ScopedNoAllocation::ScopedNoAllocation() { ++noAllocationDepth; }
+ScopedNoAllocation::~ScopedNoAllocation() { --noAllocationDepth; }
+
+ScopedAllowAllocation::ScopedAllowAllocation() : previousDepth(noAllocationDepth) { noAllocationDepth = 0; }
+ScopedAllowAllocation::~ScopedAllowAllocation() { noAllocationDepth = previousDepth; }
+
+bool isAllocationForbidden() { return noAllocationDepth > 0; }
+}
+
+#else
+
+namespace RealtimeGuard
+{
+bool isAllocationForbidden() { return false; }
+}
+
+#endif
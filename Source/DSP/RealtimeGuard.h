@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.h
+    Created: 17 Oct 2026 9:41:12am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//when enabled, the global operator new is replaced and any allocation made while a
+//ScopedNoAllocation is alive on the calling thread hits a jassert.
+#ifndef P13_TRAP_REALTIME_ALLOCATIONS
+ #define P13_TRAP_REALTIME_ALLOCATIONS JUCE_DEBUG
+#endif
+
+namespace RealtimeGuard
+{
+/*
+ put one of these at the top of processBlock().
+ In release builds it compiles away to nothing.
+ */
+struct ScopedNoAllocation
+{
+#if P13_TRAP_REALTIME_ALLOCATIONS
+    ScopedNoAllocation();
+    ~ScopedNoAllocation();
+#else
+    ScopedNoAllocation() = default;
+#endif
+    JUCE_DECLARE_NON_COPYABLE(ScopedNoAllocation)
+};
+
+/*
+ lifts the trap for code that is allowed to allocate on the audio thread,
+ i.e. the jassert machinery itself.
+ */
+struct ScopedAllowAllocation
+{
+#if P13_TRAP_REALTIME_ALLOCATIONS
+    ScopedAllowAllocation();
+    ~ScopedAllowAllocation();
+private:
+    int previousDepth = 0;
+#else
+    ScopedAllowAllocation() = default;
+#endif
+    JUCE_DECLARE_NON_COPYABLE(ScopedAllowAllocation)
+};
+
+bool isAllocationForbidden();
+}
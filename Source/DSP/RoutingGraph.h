@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    RoutingGraph.h
+    Created: 21 Oct 2026 3:26:50pm
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+/*
+ Serial/parallel routing for a chain holding each of the N values of an enum once.
+ Every stage is assigned a branch: 0 keeps it on the serial path, 1...N puts it on that
+ parallel branch. In a given order, each run of consecutive stages on parallel branches
+ forms one parallel section. The section's stages are grouped by branch (keeping their
+ order), every branch processes its own copy of the section's input, and the outputs are
+ averaged, each scaled by its branch mix. Moving a stage onto a second branch then keeps the
+ section's level instead of adding the branches' outputs up.
+ The routing is kept apart from the order so reordering stages keeps their branches.
+ */
+template <typename Enum, size_t N>
+struct RoutingGraph
+{
+    using Order = std::array<Enum, N>;
+    static constexpr size_t MaxBranches = N;
+
+    RoutingGraph() { branchMix.fill(1.f); }
+
+    //indexed by Enum. 0 is the serial path.
+    std::array<int, N> branches {};
+    //linear output gain of branches 1...MaxBranches, on top of the 1 / numLanes of their section
+    std::array<float, MaxBranches> branchMix;
+
+    int getBranch(Enum stage) const
+    {
+        auto index = static_cast<size_t>(stage);
+        return index < N ? branches[index] : 0;
+    }
+
+    //stages run one after another: the serial path between sections, or one parallel branch
+    struct Lane
+    {
+        std::array<Enum, N> stages {};
+        size_t numStages = 0;
+        int branch = 0;
+        float mix = 1.f;
+    };
+
+    struct Section
+    {
+        std::array<Lane, N> lanes {};
+        size_t numLanes = 0;
+        bool parallel = false;
+    };
+
+    //fixed size, so plans can be rebuilt on the audio thread
+    struct Plan
+    {
+        std::array<Section, N> sections {};
+        size_t numSections = 0;
+
+        bool isSerial() const
+        {
+            for (size_t i = 0; i < numSections; ++i)
+                if (sections[i].parallel)
+                    return false;
+            return true;
+        }
+    };
+
+    Plan makePlan(const Order& order) const
+    {
+        Plan plan;
+        for (size_t i = 0; i < N;)
+        {
+            auto& section = plan.sections[plan.numSections++];
+            section.parallel = getBranch(order[i]) != 0;
+            if (section.parallel == false)
+            {
+                auto& lane = section.lanes[section.numLanes++];
+                for (; i < N && getBranch(order[i]) == 0; ++i)
+                    lane.stages[lane.numStages++] = order[i];
+                continue;
+            }
+
+            for (; i < N && getBranch(order[i]) != 0; ++i)
+            {
+                auto branch = getBranch(order[i]);
+                size_t laneIndex = 0;
+                while (laneIndex < section.numLanes && section.lanes[laneIndex].branch != branch)
+                    ++laneIndex;
+
+                auto& lane = section.lanes[laneIndex];
+                if (laneIndex == section.numLanes)
+                {
+                    ++section.numLanes;
+                    lane.branch = branch;
+                    lane.mix = branch <= static_cast<int>(MaxBranches) ? branchMix[static_cast<size_t>(branch - 1)] : 1.f;
+                }
+                lane.stages[lane.numStages++] = order[i];
+            }
+
+            for (size_t l = 0; l < section.numLanes; ++l)
+                section.lanes[l].mix /= static_cast<float>(section.numLanes);
+        }
+        return plan;
+    }
+};
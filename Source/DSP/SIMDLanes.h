@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    SIMDLanes.h
+    Created: 17 Oct 2026 1:18:55pm
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Packs up to NumLanes channels of a float block into a single interleaved channel of
+ SIMDRegister<float>, so a processor templated on the register type advances every
+ channel in one pass while sharing its coefficients. Unused lanes are fed zeros.
+ */
+struct SIMDLanes
+{
+    using Register = juce::dsp::SIMDRegister<float>;
+    static constexpr size_t NumLanes = Register::SIMDNumElements;
+
+    void prepare(size_t maxBlockSize)
+    {
+        interleaved = juce::dsp::AudioBlock<Register>(interleavedData, 1, maxBlockSize);
+        interleaved.clear();
+    }
+
+    juce::dsp::AudioBlock<Register> interleave(const juce::dsp::AudioBlock<float>& block)
+    {
+        const auto numChannels = block.getNumChannels();
+        const auto numSamples = block.getNumSamples();
+        jassert(numChannels <= NumLanes);
+        jassert(numSamples <= interleaved.getNumSamples());
+
+        auto* dest = reinterpret_cast<float*>(interleaved.getChannelPointer(0));
+        for (size_t lane = 0; lane < NumLanes; ++lane)
+        {
+            if (lane < numChannels)
+            {
+                auto* src = block.getChannelPointer(lane);
+                for (size_t i = 0; i < numSamples; ++i)
+                    dest[i * NumLanes + lane] = src[i];
+            }
+            else
+            {
+                for (size_t i = 0; i < numSamples; ++i)
+                    dest[i * NumLanes + lane] = 0.f;
+            }
+        }
+
+        return interleaved.getSubBlock(0, numSamples);
+    }
+
+    void deinterleave(const juce::dsp::AudioBlock<float>& block) const
+    {
+        const auto numChannels = juce::jmin(block.getNumChannels(), NumLanes);
+        const auto numSamples = block.getNumSamples();
+
+        auto* src = reinterpret_cast<const float*>(interleaved.getChannelPointer(0));
+        for (size_t lane = 0; lane < numChannels; ++lane)
+        {
+            auto* dest = block.getChannelPointer(lane);
+            for (size_t i = 0; i < numSamples; ++i)
+                dest[i] = src[i * NumLanes + lane];
+        }
+    }
+
+private:
+    juce::HeapBlock<char> interleavedData;
+    juce::dsp::AudioBlock<Register> interleaved;
+};
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    SPSCRing.h
+    Created: 27 Oct 2026 10:12:46am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <type_traits>
+
+/*
+ Bounded ring of trivially copyable items from exactly one producer thread to exactly one
+ consumer thread. Each side owns one index and only reads the other's, so a push or a pop
+ is a copy and one release store, with no compare-exchange loop. Use LockFreeQueue when
+ there can be more than one thread on either side.
+ */
+template <typename T, size_t Capacity>
+struct SPSCRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "items are copied in and out of the slots");
+
+    SPSCRing() = default;
+
+    //producer only. Returns false if the ring is full.
+    bool push(const T& item)
+    {
+        auto write = writePosition.load(std::memory_order_relaxed);
+        if (write - readPosition.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        items[write & Mask] = item;
+        writePosition.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    //consumer only. Returns false if the ring is empty.
+    bool pop(T& item)
+    {
+        auto read = readPosition.load(std::memory_order_relaxed);
+        if (read == writePosition.load(std::memory_order_acquire))
+            return false;
+
+        item = items[read & Mask];
+        readPosition.store(read + 1, std::memory_order_release);
+        return true;
+    }
+private:
+    static constexpr size_t Mask = Capacity - 1;
+    std::array<T, Capacity> items {};
+    alignas(64) std::atomic<size_t> writePosition {0};
+    alignas(64) std::atomic<size_t> readPosition {0};
+
+    JUCE_DECLARE_NON_COPYABLE(SPSCRing)
+};
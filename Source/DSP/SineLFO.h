@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    SineLFO.h
+    Created: 20 Oct 2026 4:05:37pm
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Wavetable sine LFO that follows juce::dsp::Oscillator initialised with std::sin:
+ it outputs sin(phase - pi) before advancing, and its frequency glides linearly over 50ms.
+ The table is shared by every instance and read with linear interpolation.
+ */
+struct SineLFO
+{
+    static constexpr size_t TableSize = 4096;
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        getTable(); //builds the table here rather than on the audio thread
+        reset();
+    }
+
+    //snaps the frequency to its target and restarts the phase
+    void reset()
+    {
+        phase = 0.f;
+        frequency.reset(sampleRate, 0.05);
+    }
+
+    void setFrequency(float hz) { frequency.setTargetValue(hz); }
+
+    float processSample()
+    {
+        auto value = lookup(phase);
+        //the phase is accumulated in radians exactly like juce::dsp::Phase so the two don't drift apart
+        phase += juce::MathConstants<float>::twoPi * frequency.getNextValue() / static_cast<float>(sampleRate);
+        while (phase >= juce::MathConstants<float>::twoPi)
+            phase -= juce::MathConstants<float>::twoPi;
+        return value;
+    }
+
+    //also returns the value a quarter cycle ahead, so any fixed phase offset can be had as
+    //value * cos(offset) + quadrature * sin(offset) without another table read per offset
+    float processSample(float& quadrature)
+    {
+        auto quarterAhead = phase + juce::MathConstants<float>::halfPi;
+        if (quarterAhead >= juce::MathConstants<float>::twoPi)
+            quarterAhead -= juce::MathConstants<float>::twoPi;
+        quadrature = lookup(quarterAhead);
+        return processSample();
+    }
+
+    //phase in radians, [0, 2pi)
+    static float lookup(float phaseRadians)
+    {
+        const auto& table = getTable();
+        auto position = juce::jmin(phaseRadians * (static_cast<float>(TableSize) / juce::MathConstants<float>::twoPi), std::nextafter(static_cast<float>(TableSize), 0.f));
+        auto index = static_cast<size_t>(position);
+        auto frac = position - static_cast<float>(index);
+        return table[index] + frac * (table[index + 1] - table[index]);
+    }
+private:
+    double sampleRate = 44100.0;
+    float phase = 0.f;
+    juce::SmoothedValue<float> frequency;
+    static const std::array<float, TableSize + 1>& getTable()
+    {
+        //one guard point so lookup() never wraps
+        static const auto table = []
+        {
+            std::array<float, TableSize + 1> t {};
+            for (size_t i = 0; i <= TableSize; ++i)
+                t[i] = static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * static_cast<double>(i) / TableSize - juce::MathConstants<double>::pi));
+            return t;
+        }();
+        return table;
+    }
+};
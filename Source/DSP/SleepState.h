@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    SleepState.h
+    Created: 23 Oct 2026 2:15:37pm
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Decides when processing can stop for a silent input. The input has to stay at or below
+ SilenceThreshold for longer than the tail, and the output has to fall below
+ SleepThreshold, before the processor goes to sleep. Any louder input wakes it in the
+ same block. While asleep the output is silence and nothing needs to run.
+ */
+struct SleepState
+{
+    static constexpr float SilenceThreshold = 1.0e-6f; //about -120 dBFS
+    static constexpr float SleepThreshold = 1.0e-5f; //about -100 dBFS
+
+    void reset()
+    {
+        silentSamples = 0;
+        asleep = false;
+        woke = false;
+    }
+
+    //call with the peak of the input before processing. Returns true if the block can be skipped.
+    bool beginBlock(float inputPeak, int numSamples)
+    {
+        woke = false;
+        if (inputPeak > SilenceThreshold)
+        {
+            woke = asleep;
+            silentSamples = 0;
+            asleep = false;
+            return false;
+        }
+
+        silentSamples += numSamples;
+        return asleep;
+    }
+
+    //call with the peak of the output of a block that was processed, and the current tail length
+    void endBlock(float outputPeak, juce::int64 tailSamples)
+    {
+        if (silentSamples >= tailSamples && silentSamples > 0)
+            asleep = outputPeak < SleepThreshold;
+    }
+
+    //silent input is still counted while awake, so the tail is only compared when it matters
+    bool isCountingSilence() const { return silentSamples > 0; }
+    bool isAsleep() const { return asleep; }
+
+    //true for the block that ended a sleep. The parameters kept moving while asleep, so anything
+    //that glides should jump to where they are now rather than ramp from where it stopped.
+    bool hasJustWoken() const { return woke; }
+private:
+    juce::int64 silentSamples = 0;
+    bool asleep = false, woke = false;
+};
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    StageOversampler.h
+    Created: 19 Oct 2026 2:37:05pm
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Denormals.h"
+
+/*
+ Selectable 2x/4x/8x oversampling around a single nonlinear stage, using juce's polyphase
+ half-band IIR (low latency) or equiripple FIR (linear phase) filters.
+ Every factor/filter combination is built in prepare(), so switching on the audio thread
+ is just a pointer swap and a reset.
+ */
+struct StageOversampler
+{
+    static juce::StringArray getChoices()
+    {
+        return { "Off", "2x IIR", "4x IIR", "8x IIR", "2x FIR", "4x FIR", "8x FIR" };
+    }
+
+    static constexpr size_t MaxOrder = 3; //8x
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        using Filter = juce::dsp::Oversampling<float>::FilterType;
+
+        for (size_t i = 0; i < oversamplers.size(); ++i)
+        {
+            auto order = i % MaxOrder + 1;
+            auto filter = i < MaxOrder ? Filter::filterHalfBandPolyphaseIIR : Filter::filterHalfBandFIREquiripple;
+
+            //integer latency so the host can compensate exactly
+            oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>>(spec.numChannels, order, filter, true, true);
+            oversamplers[i]->initProcessing(spec.maximumBlockSize);
+        }
+
+        choice = 0;
+        current = nullptr;
+    }
+
+    //index into getChoices(). Returns true if the choice changed, in which case the wrapped
+    //stage needs to be re-prepared at getFactor() times the host rate.
+    bool setChoice(int newChoice)
+    {
+        newChoice = juce::jlimit(0, static_cast<int>(oversamplers.size()), newChoice);
+        if (newChoice == choice)
+            return false;
+
+        choice = newChoice;
+        current = choice == 0 ? nullptr : oversamplers[static_cast<size_t>(choice - 1)].get();
+        if (current != nullptr)
+            current->reset();
+
+        return true;
+    }
+
+    //clears the up/down filters of the current choice, e.g. when the stage comes back from bypass
+    void reset()
+    {
+        if (current != nullptr)
+            current->reset();
+    }
+
+    size_t getOrder() const { return choice == 0 ? 0 : static_cast<size_t>(choice - 1) % MaxOrder + 1; }
+    size_t getFactor() const { return size_t(1) << getOrder(); }
+    float getLatencyInSamples() const { return current != nullptr ? current->getLatencyInSamples() : 0.f; }
+
+    //the most any choice can add, for sizing latency compensation in prepare()
+    float getMaxLatencyInSamples() const
+    {
+        float latency = 0.f;
+        for (const auto& oversampler : oversamplers)
+            if (oversampler != nullptr)
+                latency = juce::jmax(latency, oversampler->getLatencyInSamples());
+        return latency;
+    }
+
+    /*
+     runs processOversampled(context) on the upsampled block. The up/down filters run even
+     when the context is bypassed so the latency doesn't jump when the stage is toggled.
+     A caller skipping the stage entirely has to delay the signal by getLatencyInSamples() itself.
+     Both filters are fed Denormals::DCOffset so their recursive state never decays into denormals.
+     */
+    template <typename ProcessFn>
+    void process(const juce::dsp::ProcessContextReplacing<float>& context, ProcessFn&& processOversampled)
+    {
+        if (current == nullptr)
+        {
+            processOversampled(context);
+            return;
+        }
+
+        auto block = context.getOutputBlock();
+        block += Denormals::DCOffset;
+        auto upsampled = current->processSamplesUp(block);
+        juce::dsp::ProcessContextReplacing<float> upsampledContext(upsampled);
+        upsampledContext.isBypassed = context.isBypassed;
+
+        processOversampled(upsampledContext);
+
+        upsampled += Denormals::DCOffset;
+        current->processSamplesDown(block);
+    }
+
+private:
+    //IIR 2x, 4x, 8x then FIR 2x, 4x, 8x, matching getChoices() after "Off"
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, 2 * MaxOrder> oversamplers;
+    juce::dsp::Oversampling<float>* current = nullptr;
+    int choice = 0;
+};
@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    WaveshaperOverdrive.h
+    Created: 20 Oct 2026 10:18:26am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDLanes.h"
+#include "Denormals.h"
+
+enum class OverdriveCurve
+{
+    Cubic,
+    Quintic,
+    HardClip,
+    Asymmetric,
+    END_OF_LIST,
+};
+
+/*
+ Memoryless saturation with a one-pole high-pass before it (pre tone), a DC blocker and a
+ one-pole low-pass after it (post tone). Every curve is a clamped polynomial, so a whole
+ interleaved SIMDLanes block is shaped with nothing but multiplies, adds and min/max.
+ The curves are scaled to unity gain for small signals and saturate at +-1.
+ */
+struct WaveshaperOverdrive
+{
+    using Register = SIMDLanes::Register;
+
+    static juce::StringArray getCurveChoices() { return { "Cubic", "Quintic", "Hard Clip", "Asymmetric" }; }
+
+    //the ends of the tone ranges switch the tone filters off
+    static constexpr float MinPreToneHz = 20.f;
+    static constexpr float MaxPostToneHz = 20000.f;
+    static constexpr float DCBlockerHz = 10.f;
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        dcCoefficient = getOnePoleCoefficient(DCBlockerHz);
+        preToneHz = postToneHz = -1.f; //recompute both for the new rate
+        reset();
+    }
+
+    void reset()
+    {
+        preToneState = dcState = postToneState = Register::expand(0.f);
+    }
+
+    void setCurve(OverdriveCurve newCurve) { curve = newCurve; }
+
+    void setPreToneHz(float hz)
+    {
+        if (hz == preToneHz)
+            return;
+        preToneHz = hz;
+        preToneCoefficient = hz <= MinPreToneHz ? 0.f : getOnePoleCoefficient(hz);
+    }
+
+    void setPostToneHz(float hz)
+    {
+        if (hz == postToneHz)
+            return;
+        postToneHz = hz;
+        postToneCoefficient = hz >= MaxPostToneHz ? 1.f : getOnePoleCoefficient(hz);
+    }
+
+    //drive holds one gain per host-rate sample. When oversampled, each value covers 2^oversamplingOrder samples.
+    void process(const juce::dsp::AudioBlock<Register>& block, const float* drive, size_t oversamplingOrder)
+    {
+        switch (curve)
+        {
+            case OverdriveCurve::Cubic:      processWithCurve<OverdriveCurve::Cubic>(block, drive, oversamplingOrder); break;
+            case OverdriveCurve::Quintic:    processWithCurve<OverdriveCurve::Quintic>(block, drive, oversamplingOrder); break;
+            case OverdriveCurve::HardClip:   processWithCurve<OverdriveCurve::HardClip>(block, drive, oversamplingOrder); break;
+            case OverdriveCurve::Asymmetric: processWithCurve<OverdriveCurve::Asymmetric>(block, drive, oversamplingOrder); break;
+            case OverdriveCurve::END_OF_LIST: jassertfalse; break;
+        }
+    }
+private:
+    double sampleRate = 44100.0;
+    OverdriveCurve curve = OverdriveCurve::Cubic;
+    float preToneHz = -1.f, postToneHz = -1.f;
+    float preToneCoefficient = 0.f, dcCoefficient = 0.f, postToneCoefficient = 1.f;
+    Register preToneState, dcState, postToneState;
+
+    float getOnePoleCoefficient(float hz) const
+    {
+        return 1.f - static_cast<float>(std::exp(-juce::MathConstants<double>::twoPi * hz / sampleRate));
+    }
+
+    static Register clamp(Register x)
+    {
+        return Register::min(Register::max(x, Register::expand(-1.f)), Register::expand(1.f));
+    }
+
+    //1.5x - 0.5x^3, reaches 1 with zero slope at x = 1
+    static Register cubic(Register x)
+    {
+        x = clamp(x * (1.f / 1.5f));
+        return x * (Register::expand(1.5f) - x * x * 0.5f);
+    }
+
+    template <OverdriveCurve Curve>
+    static Register shape(Register x)
+    {
+        if constexpr (Curve == OverdriveCurve::Cubic)
+            return cubic(x);
+        else if constexpr (Curve == OverdriveCurve::Quintic)
+        {
+            //(15x - 10x^3 + 3x^5) / 8, flat to the second derivative at x = 1
+            x = clamp(x * (8.f / 15.f));
+            auto x2 = x * x;
+            return x * (Register::expand(1.875f) + x2 * (Register::expand(-1.25f) + x2 * 0.375f));
+        }
+        else if constexpr (Curve == OverdriveCurve::HardClip)
+            return clamp(x);
+        else
+        {
+            //biasing the cubic adds even harmonics. The offset it leaves is removed here and the rest by the DC blocker.
+            constexpr float bias = 0.3f;
+            constexpr float biasScaled = bias / 1.5f;
+            constexpr float offset = biasScaled * (1.5f - 0.5f * biasScaled * biasScaled); //cubic(bias)
+            return cubic(x + bias) - offset;
+        }
+    }
+
+    template <OverdriveCurve Curve>
+    void processWithCurve(const juce::dsp::AudioBlock<Register>& block, const float* drive, size_t oversamplingOrder)
+    {
+        auto* samples = block.getChannelPointer(0);
+        const auto numSamples = block.getNumSamples();
+        auto pre = preToneState, dc = dcState, post = postToneState;
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto x = samples[i];
+            pre += (x - pre) * preToneCoefficient;
+            x = shape<Curve>((x - pre) * drive[i >> oversamplingOrder]);
+            dc += (x - dc) * dcCoefficient;
+            x -= dc;
+            post += (x - post) * postToneCoefficient;
+            samples[i] = post;
+        }
+        preToneState = Denormals::flush(pre);
+        dcState = Denormals::flush(dc);
+        postToneState = Denormals::flush(post);
+    }
+};
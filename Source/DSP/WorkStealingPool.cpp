@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    WorkStealingPool.cpp
+    Created: 22 Oct 2026 10:07:41am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(int numWorkers)
+{
+    numWorkers = juce::jmax(0, numWorkers);
+    numThreads = numWorkers + 1;
+    slices = std::make_unique<Slice[]>(static_cast<size_t>(numThreads));
+
+    workers.reserve(static_cast<size_t>(numWorkers));
+    for (int i = 0; i < numWorkers; ++i)
+        workers.emplace_back([this, i] { workerLoop(i + 1); }); //the caller of run() is thread 0
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void WorkStealingPool::runErased(int numTasks, TaskFn fn, const void* context)
+{
+    if (numTasks <= 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        //a worker that woke too late for the previous run may still be scanning the old slices
+        while (activeWorkers.load(std::memory_order_acquire) > 0)
+            std::this_thread::yield();
+
+        for (int t = 0; t < numThreads; ++t)
+        {
+            slices[static_cast<size_t>(t)].next.store(numTasks * t / numThreads, std::memory_order_relaxed);
+            slices[static_cast<size_t>(t)].end = numTasks * (t + 1) / numThreads;
+        }
+
+        taskFn = fn;
+        taskContext = context;
+        remaining.store(numTasks, std::memory_order_relaxed);
+        ++generation;
+    }
+    wake.notify_all();
+
+    runTasksFrom(0);
+
+    while (remaining.load(std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+}
+
+void WorkStealingPool::workerLoop(int threadIndex)
+{
+    juce::uint64 lastGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return quit || generation != lastGeneration; });
+            if (quit)
+                return;
+
+            lastGeneration = generation;
+            activeWorkers.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        runTasksFrom(threadIndex);
+        activeWorkers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void WorkStealingPool::runTasksFrom(int threadIndex)
+{
+    //own slice first, then steal from the others in turn
+    for (int i = 0; i < numThreads; ++i)
+    {
+        auto& slice = slices[static_cast<size_t>((threadIndex + i) % numThreads)];
+        for (;;)
+        {
+            auto index = slice.next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= slice.end)
+                break;
+
+            taskFn(taskContext, index);
+            remaining.fetch_sub(1, std::memory_order_release);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    WorkStealingPool.h
+    Created: 22 Oct 2026 10:07:41am
+    Author:  Aaron Petrini
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/*
+ Small thread pool for spreading a block's independent work (parallel branches, channel
+ groups) across cores when rendering offline. run() gives every thread, the caller
+ included, an equal slice of the task indices. A thread that finishes its slice steals
+ from the others' slices.
+ Which thread runs a task isn't deterministic, so each task must write only to its own
+ storage and the caller combines the results in a fixed order.
+ The threads start in the constructor, so build the pool outside the audio callback.
+ */
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(int numWorkers);
+    ~WorkStealingPool();
+
+    int getNumThreads() const { return numThreads; }
+
+    //calls task(0) ... task(numTasks - 1) and returns once all of them have finished
+    template <typename Task>
+    void run(int numTasks, const Task& task)
+    {
+        runErased(numTasks, [](const void* context, int index) { (*static_cast<const Task*>(context))(index); }, &task);
+    }
+private:
+    using TaskFn = void (*)(const void*, int);
+
+    //a contiguous range of task indices, claimed one at a time by its owner and by thieves
+    struct alignas(64) Slice
+    {
+        std::atomic<int> next {0};
+        int end = 0;
+    };
+
+    void runErased(int numTasks, TaskFn fn, const void* context);
+    void workerLoop(int threadIndex);
+    void runTasksFrom(int threadIndex);
+
+    int numThreads = 1;
+    std::vector<std::thread> workers;
+    std::unique_ptr<Slice[]> slices;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    juce::uint64 generation = 0;
+    bool quit = false;
+
+    TaskFn taskFn = nullptr;
+    const void* taskContext = nullptr;
+    std::atomic<int> remaining {0}, activeWorkers {0};
+
+    JUCE_DECLARE_NON_COPYABLE(WorkStealingPool)
+};
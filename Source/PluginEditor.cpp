@@ -26,6 +26,8 @@ static juce::String getNameFromDSPOption(Project13AudioProcessor::DSP_Option opt
             return "LADDERFILTER";
         case Project13AudioProcessor::DSP_Option::GeneralFilter:
             return "GEN FILTER";
+        case Project13AudioProcessor::DSP_Option::Delay:
+            return "DELAY";
         case Project13AudioProcessor::DSP_Option::END_OF_LIST:
             jassertfalse;
     }
@@ -44,6 +46,8 @@ static Project13AudioProcessor::DSP_Option getDSPOptionFromName(juce::String nam
         return Project13AudioProcessor::DSP_Option::LadderFilter;
     if(name == "GEN FILTER")
         return Project13AudioProcessor::DSP_Option::GeneralFilter;
+    if(name == "DELAY")
+        return Project13AudioProcessor::DSP_Option::Delay;
     
     return Project13AudioProcessor::DSP_Option::END_OF_LIST;
 }
@@ -538,17 +542,46 @@ Project13AudioProcessorEditor::Project13AudioProcessorEditor (Project13AudioProc
     
     inGainControl = std::make_unique<RotarySliderWithLabels>(audioProcessor.inputGain, "dB", "IN");
     outGainControl = std::make_unique<RotarySliderWithLabels>(audioProcessor.outputGain, "dB", "OUT");
+    globalMixControl = std::make_unique<RotarySliderWithLabels>(audioProcessor.globalMixPercent, "%", "MIX");
     
     addAndMakeVisible(inGainControl.get());
     addAndMakeVisible(outGainControl.get());
+    addAndMakeVisible(globalMixControl.get());
     
     SimpleMBComp::addLabelPairs(inGainControl->labels, *audioProcessor.inputGain, "dB");
     SimpleMBComp::addLabelPairs(outGainControl->labels, *audioProcessor.outputGain, "dB");
+    SimpleMBComp::addLabelPairs(globalMixControl->labels, *audioProcessor.globalMixPercent, "%");
     
     inGainAttachment = std::make_unique<juce::SliderParameterAttachment>(*audioProcessor.inputGain, *inGainControl);
     outGainAttachment = std::make_unique<juce::SliderParameterAttachment>(*audioProcessor.outputGain, *outGainControl);
+    globalMixAttachment = std::make_unique<juce::SliderParameterAttachment>(*audioProcessor.globalMixPercent, *globalMixControl);
     
-    audioProcessor.guiNeedsLatestDspOrder.set(true);
+    for (auto size : {16, 32, 64, 128, 256, 512})
+        subBlockSizeBox.addItem("SUB " + juce::String(size), size);
+    syncSubBlockSizeBox();
+    subBlockSizeBox.onChange = [this]()
+    {
+        audioProcessor.setSubBlockSize(subBlockSizeBox.getSelectedId());
+    };
+    addAndMakeVisible(subBlockSizeBox);
+    
+    routingBox.addItem("SERIAL", 1);
+    for (int branch = 1; branch <= static_cast<int>(Project13AudioProcessor::DSP_Routing::MaxBranches); ++branch)
+        routingBox.addItem("BRANCH " + juce::String(branch), branch + 1);
+    routingBox.onChange = [this]()
+    {
+        auto* tab = dynamic_cast<ExtendedTabBarButton*>(tabbedComponent.getTabButton(tabbedComponent.getCurrentTabIndex()));
+        auto index = tab != nullptr ? static_cast<size_t>(tab->getOption()) : Project13AudioProcessor::NumDSPOptions;
+        if (index >= Project13AudioProcessor::NumDSPOptions || routingBox.getSelectedId() < 1)
+            return;
+        
+        currentGraph.routing.branches[index] = routingBox.getSelectedId() - 1;
+        audioProcessor.sendCommandFromMessageThread(Project13AudioProcessor::DSP_Command::presetSwap(currentGraph));
+    };
+    addAndMakeVisible(routingBox);
+    
+    //the order may have changed since the last editor was open
+    audioProcessor.sendCommandFromMessageThread(Project13AudioProcessor::DSP_Command::sync());
     
     tabbedComponent.addListener(this);
     startTimerHz(30);
@@ -565,12 +598,19 @@ Project13AudioProcessorEditor::~Project13AudioProcessorEditor()
 void Project13AudioProcessorEditor::paint (juce::Graphics& g)
 {
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-    auto fillMeter = [&] (auto rect, const auto& rmsSource)
+    auto fillMeter = [&] (auto rect, const MeterBallistics::Channel& levels)
     {
         g.setColour(juce::Colours::black);
         g.fillRect(rect);
         
-        auto rms = rmsSource.get();
+        //a latched clip lights the top of the bar until the meter is clicked
+        if (levels.clipped)
+        {
+            g.setColour(juce::Colours::red);
+            g.fillRect(rect.withHeight(tickIndent / 2));
+        }
+        
+        auto rms = levels.level;
         if (rms > 1.f)
         {
             g.setColour(juce::Colours::red);
@@ -585,6 +625,15 @@ void Project13AudioProcessorEditor::paint (juce::Graphics& g)
         rms = juce::jmin<float>(rms, 1.f);
         g.setColour(juce::Colours::green);
         g.fillRect(rect.withY(juce::jmap<float>(juce::Decibels::gainToDecibels(rms), NEGATIVE_INFINITY, MAX_DECIBELS, rect.getBottom(), rect.getY())).withBottom(rect.getBottom()));
+        
+        //the held peak as a line over the RMS bar
+        auto peakDb = juce::jlimit<float>(NEGATIVE_INFINITY, MAX_DECIBELS, juce::Decibels::gainToDecibels(levels.heldPeak, static_cast<float>(NEGATIVE_INFINITY)));
+        if (peakDb > NEGATIVE_INFINITY)
+        {
+            auto y = juce::jmap<float>(peakDb, NEGATIVE_INFINITY, MAX_DECIBELS, rect.getBottom(), rect.getY());
+            g.setColour(levels.heldPeak > 1.f ? juce::Colours::red : juce::Colours::white);
+            g.drawHorizontalLine(juce::roundToInt(y), static_cast<float>(rect.getX()), static_cast<float>(rect.getRight()));
+        }
     };
     
     
@@ -611,7 +660,7 @@ void Project13AudioProcessorEditor::paint (juce::Graphics& g)
     };
     
     //Lambda draws labels and computes rectangles that form each channel, draws ticks
-    auto drawMeter = [&fillMeter, &drawTicks](juce::Rectangle<int> rect, juce::Graphics& g, const juce::Atomic<float>& leftSource, const juce::Atomic<float>& rightSource, const juce::String& label)
+    auto drawMeter = [&fillMeter, &drawTicks](juce::Rectangle<int> rect, juce::Graphics& g, const auto& sources, int numChannels, const juce::String& label)
     {
         g.setColour(juce::Colours::green);
         g.drawRect(rect);
@@ -626,8 +675,24 @@ void Project13AudioProcessorEditor::paint (juce::Graphics& g)
         const auto leftChan = rect.removeFromLeft(meterChanWidth);
         const auto rightChan = rect.removeFromRight(meterChanWidth);
         
-        fillMeter(leftChan, leftSource);
-        fillMeter(rightChan, leftSource);
+        //the first half of the channels share the left column, the rest the right one. Mono fills both.
+        numChannels = juce::jlimit(1, static_cast<int>(sources.size()), numChannels);
+        const auto numLeft = (numChannels + 1) / 2;
+        const auto numRight = juce::jmax(1, numChannels - numLeft);
+        
+        auto fillColumn = [&](juce::Rectangle<int> column, int firstChannel, int count)
+        {
+            const auto width = column.getWidth() / count;
+            for (int i = 0; i < count; ++i)
+            {
+                auto channel = juce::jmin(firstChannel + i, numChannels - 1);
+                auto bar = i == count - 1 ? column : column.removeFromLeft(width);
+                fillMeter(bar, sources[static_cast<size_t>(channel)]);
+            }
+        };
+        
+        fillColumn(leftChan, 0, numLeft);
+        fillColumn(rightChan, numLeft, numRight);
         drawTicks(meterArea, leftChan.getRight(), rightChan.getX());
     };
     
@@ -637,8 +702,33 @@ void Project13AudioProcessorEditor::paint (juce::Graphics& g)
     auto preMeterArea = bounds.removeFromLeft(meterWidth);
     auto postMeterArea = bounds.removeFromRight(meterWidth);
     
-    drawMeter(preMeterArea, g, audioProcessor.leftPreRMS, audioProcessor.rightPreRMS, "In");
-    drawMeter(postMeterArea, g, audioProcessor.leftPostRMS, audioProcessor.rightPostRMS, "Out");
+    //the loudest held sample peak under In, and loudness and the loudest held true peak under Out
+    auto preReadoutArea = preMeterArea.removeFromBottom(readoutHeight * 3);
+    auto postReadoutArea = postMeterArea.removeFromBottom(readoutHeight * 3);
+    
+    const auto numChannels = meterChannels > 0 ? meterChannels : audioProcessor.getTotalNumInputChannels();
+    drawMeter(preMeterArea, g, inputBallistics.channels, numChannels, "In");
+    drawMeter(postMeterArea, g, outputBallistics.channels, numChannels, "Out");
+    
+    float inputPeak = 0.f, outputTruePeak = 0.f;
+    for (size_t ch = 0; ch < static_cast<size_t>(juce::jlimit(0, Project13AudioProcessor::MaxChannels, numChannels)); ++ch)
+    {
+        inputPeak = juce::jmax(inputPeak, inputBallistics.channels[ch].heldPeak);
+        outputTruePeak = juce::jmax(outputTruePeak, outputBallistics.channels[ch].heldPeak);
+    }
+    
+    g.setFont(static_cast<float>(readoutHeight));
+    auto drawReadout = [&g](juce::Rectangle<int>& area, const juce::String& name, float value, bool over)
+    {
+        g.setColour(over ? juce::Colours::red : juce::Colours::white);
+        g.drawText(name + " " + juce::String(value, 1), area.removeFromTop(readoutHeight), juce::Justification::centred);
+    };
+    
+    auto toDb = [](float gain) { return juce::Decibels::gainToDecibels(gain, static_cast<float>(NEGATIVE_INFINITY)); };
+    drawReadout(preReadoutArea, "PK", toDb(inputPeak), inputPeak > 1.f);
+    drawReadout(postReadoutArea, "M", momentaryLufs, false);
+    drawReadout(postReadoutArea, "S", shortTermLufs, false);
+    drawReadout(postReadoutArea, "TP", toDb(outputTruePeak), outputTruePeak > 1.f);
     
 }
 
@@ -658,36 +748,112 @@ void Project13AudioProcessorEditor::resized()
     analyzer.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.7));
     
     tabbedComponent.setBounds(bounds.removeFromTop(30));
+    auto settingsArea = bounds.removeFromRight(ioControlSize);
+    subBlockSizeBox.setBounds(settingsArea.removeFromTop(24));
+    routingBox.setBounds(settingsArea.removeFromTop(24));
+    globalMixControl -> setBounds(settingsArea);
     dspGUI.setBounds(bounds);
 }
 
 void Project13AudioProcessorEditor::tabOrderChanged(Project13AudioProcessor::DSP_Order newOrder)
 {
     rebuildInterface();
-    audioProcessor.dspOrderFifo.push(newOrder);
+    currentGraph.order = newOrder; //so a routing change sent before the reorder's event keeps the new order
+    audioProcessor.sendCommandFromMessageThread(Project13AudioProcessor::DSP_Command::reorder(newOrder));
 }
 
-void Project13AudioProcessorEditor::timerCallback()
+void Project13AudioProcessorEditor::syncSubBlockSizeBox()
 {
-    repaint();
-    if (audioProcessor.restoreDspOrderFifo.getNumAvailableForReading() == 0)
+    //a restored session may hold a size that isn't in the list
+    auto size = audioProcessor.getSubBlockSize();
+    if (subBlockSizeBox.indexOfItemId(size) < 0)
+        subBlockSizeBox.addItem("SUB " + juce::String(size), size);
+    subBlockSizeBox.setSelectedId(size, juce::dontSendNotification);
+}
+
+void Project13AudioProcessorEditor::syncRoutingBox()
+{
+    auto* tab = dynamic_cast<ExtendedTabBarButton*>(tabbedComponent.getTabButton(tabbedComponent.getCurrentTabIndex()));
+    if (tab == nullptr)
+    {
+        routingBox.setSelectedId(0, juce::dontSendNotification);
         return;
+    }
+    
+    routingBox.setSelectedId(currentGraph.routing.getBranch(tab->getOption()) + 1, juce::dontSendNotification);
+}
+
+void Project13AudioProcessorEditor::drainMeterFrames()
+{
+    Project13AudioProcessor::MeterFrame frame;
+    bool anyFrames = false;
+    while (audioProcessor.pullMeterFrame(frame))
+    {
+        anyFrames = true;
+        meterChannels = juce::jlimit(0, Project13AudioProcessor::MaxChannels, frame.numChannels);
+        for (size_t ch = 0; ch < static_cast<size_t>(meterChannels); ++ch)
+        {
+            const auto& out = frame.output.channels[ch];
+            inputBallistics.process(ch, frame.input[ch].rms, frame.input[ch].peak, frame.seconds);
+            outputBallistics.process(ch, out.rms, out.truePeak, frame.seconds);
+        }
+        
+        momentaryLufs = frame.output.momentaryLufs;
+        shortTermLufs = frame.output.shortTermLufs;
+    }
     
-    using T = Project13AudioProcessor::DSP_Order;
-    T newOrder;
-    newOrder.fill(Project13AudioProcessor::DSP_Option::END_OF_LIST);
-    auto empty = newOrder;
-    while (audioProcessor.restoreDspOrderFifo.pull(newOrder))
+    //no blocks (e.g. the host stopped calling processBlock): let the meters fall on the timer's clock instead
+    if (anyFrames == false)
     {
-        ; //do nothing
+        const auto seconds = static_cast<float>(getTimerInterval()) * 0.001f;
+        for (size_t ch = 0; ch < static_cast<size_t>(meterChannels); ++ch)
+        {
+            inputBallistics.process(ch, 0.f, 0.f, seconds);
+            outputBallistics.process(ch, 0.f, 0.f, seconds);
+        }
     }
+}
+
+void Project13AudioProcessorEditor::mouseDown(const juce::MouseEvent& e)
+{
+    //the meters are painted by the editor, so a click that reaches it outside the child components may be on one
+    auto bounds = getLocalBounds();
+    bounds.removeFromBottom(ioControlSize);
+    if (bounds.removeFromLeft(meterWidth).contains(e.getPosition()))
+        inputBallistics.clearClips();
+    else if (bounds.removeFromRight(meterWidth).contains(e.getPosition()))
+        outputBallistics.clearClips();
     
-    if (newOrder != empty) //if u pulled nothing newOrder will be filled with end_of_list
+    repaint();
+}
+
+void Project13AudioProcessorEditor::timerCallback()
+{
+    drainMeterFrames();
+    repaint();
+    syncSubBlockSizeBox();
+    
+    //reorders came from the tabs, so only a sync or a preset swap with a new order needs the tabs rebuilt
+    using Command = Project13AudioProcessor::DSP_Command;
+    Project13AudioProcessor::DSP_Event event;
+    std::optional<Project13AudioProcessor::DSP_Order> newOrder;
+    bool anyEvents = false;
+    while (audioProcessor.pullEvent(event))
     {
-        //don't create tabs if newOrder is filled with END_OF_LIST
-        addTabsFromDSPOrder(newOrder);
+        if (event.type == Command::Type::Sync || (event.type == Command::Type::PresetSwap && event.graph.order != currentGraph.order))
+            newOrder = event.graph.order;
+        currentGraph = event.graph;
+        anyEvents = true;
     }
     
+    if (anyEvents)
+        syncRoutingBox();
+    
+    if (newOrder.has_value() == false)
+        return;
+    
+    addTabsFromDSPOrder(*newOrder);
+    
     if (selectedTabAttachment == nullptr)
     {
         selectedTabAttachment = std::make_unique<juce::ParameterAttachment>(*audioProcessor.selectedTab, [this](float tabNum)
@@ -706,6 +872,35 @@ void Project13AudioProcessorEditor::timerCallback()
     }
 }
 
+void MeterBallistics::process(size_t channel, float rms, float peak, float seconds)
+{
+    auto& c = channels[channel];
+    const auto decay = juce::Decibels::decibelsToGain(-DecayDbPerSecond * seconds);
+    
+    c.level = juce::jmax(rms, c.level * decay);
+    c.clipped = c.clipped || peak > 1.f;
+    
+    if (peak >= c.heldPeak)
+    {
+        c.heldPeak = peak;
+        c.holdSecondsLeft = PeakHoldSeconds;
+    }
+    else if (c.holdSecondsLeft > 0.f)
+    {
+        c.holdSecondsLeft -= seconds;
+    }
+    else
+    {
+        c.heldPeak = juce::jmax(peak, c.heldPeak * decay);
+    }
+}
+
+void MeterBallistics::clearClips()
+{
+    for (auto& c : channels)
+        c.clipped = false;
+}
+
 void Project13AudioProcessorEditor::addTabsFromDSPOrder(Project13AudioProcessor::DSP_Order newOrder)
 {
     tabbedComponent.clearTabs();
@@ -747,7 +942,7 @@ void Project13AudioProcessorEditor::addTabsFromDSPOrder(Project13AudioProcessor:
     tabbedComponent.setTabsColours();
     rebuildInterface();
     //if newOrder is the same from before this will do nothing because the order of DSP_Order wont change
-    audioProcessor.dspOrderFifo.push(newOrder);
+    audioProcessor.sendCommandFromMessageThread(Project13AudioProcessor::DSP_Command::reorder(newOrder));
 }
 
 void Project13AudioProcessorEditor::rebuildInterface()
@@ -760,6 +955,7 @@ void Project13AudioProcessorEditor::rebuildInterface()
         auto params = audioProcessor.getParamsForOption(option);
         jassert(params.empty() == false);
         dspGUI.rebuildInterface(params);
+        syncRoutingBox();
         if (auto btn = dynamic_cast<PowerButtonWithParam*>(etbb->getExtraComponent()))
         {
             refreshDSPGUIControlEnablement(btn);
@@ -107,6 +107,27 @@ private:
 
 struct RotarySliderWithLabels;
 
+//peak hold, decay and clip latching for one meter. It runs on the processor's meter frames in
+//audio time, so it shows the same thing whatever the repaint rate or host block size.
+struct MeterBallistics
+{
+    static constexpr float DecayDbPerSecond = 20.f;
+    static constexpr float PeakHoldSeconds = 1.5f;
+    
+    struct Channel
+    {
+        float level = 0.f, heldPeak = 0.f, holdSecondsLeft = 0.f;
+        bool clipped = false;
+    };
+    
+    //level rises at once and falls at DecayDbPerSecond. A new peak is held for PeakHoldSeconds, then falls the same way.
+    void process(size_t channel, float rms, float peak, float seconds);
+    //latches stay on until clicked
+    void clearClips();
+    
+    std::array<Channel, Project13AudioProcessor::MaxChannels> channels {};
+};
+
 struct DSP_Gui : juce::Component
 {
     DSP_Gui (Project13AudioProcessor& p);
@@ -158,6 +179,7 @@ public:
     void tabOrderChanged(Project13AudioProcessor::DSP_Order newOrder) override;
     void selectedTabChanged(int newCurrentTabIndex) override;
     void timerCallback() override;
+    void mouseDown(const juce::MouseEvent& e) override;
 private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
@@ -178,14 +200,32 @@ private:
     static constexpr int fontHeight = 24;
     static constexpr int tickIndent = 8;
     static constexpr int meterChanWidth = 24;
+    static constexpr int readoutHeight = 14;
+    
+    //fed every frame the processor pushed since the last tick. The loudness readouts show the latest frame's.
+    MeterBallistics inputBallistics, outputBallistics;
+    float momentaryLufs = OutputMeter<Project13AudioProcessor::MaxChannels>::MinLufs;
+    float shortTermLufs = OutputMeter<Project13AudioProcessor::MaxChannels>::MinLufs;
+    int meterChannels = 0;
+    void drainMeterFrames();
     
     static constexpr int ioControlSize = 100;
     
-    std::unique_ptr<RotarySliderWithLabels> inGainControl, outGainControl;
-    std::unique_ptr<juce::SliderParameterAttachment> inGainAttachment, outGainAttachment;
+    std::unique_ptr<RotarySliderWithLabels> inGainControl, outGainControl, globalMixControl;
+    std::unique_ptr<juce::SliderParameterAttachment> inGainAttachment, outGainAttachment, globalMixAttachment;
     
     std::unique_ptr<juce::ParameterAttachment> selectedTabAttachment;
     
+    //samples between control-rate updates. A session setting rather than a param, so nothing automates it.
+    juce::ComboBox subBlockSizeBox;
+    void syncSubBlockSizeBox();
+    
+    //puts the selected tab's stage on the serial path or on a parallel branch. The graph is
+    //the one the last DSP_Event reported, and changes to it are sent as preset swaps.
+    juce::ComboBox routingBox;
+    Project13AudioProcessor::DSP_Graph currentGraph;
+    void syncRoutingBox();
+    
     void addTabsFromDSPOrder(Project13AudioProcessor::DSP_Order);
     void rebuildInterface();
     void refreshDSPGUIControlEnablement(PowerButtonWithParam* button);
@@ -21,9 +21,15 @@ auto getChorusDepthName() {return juce::String("Chorus Depth %");}
 auto getChorusCenterDelayName() {return juce::String("Chorus Center Delay Ms");}
 auto getChorusFeedbackName() {return juce::String("Chorus Feedback %");}
 auto getChorusMixName() {return juce::String("Chorus Mix %");}
+auto getChorusVoicesName() {return juce::String("Chorus Voices");}
+auto getChorusSpreadName() {return juce::String("Chorus Spread %");}
 auto getChorusBypassName() {return juce::String("Chorus Bypass");}
 
 auto getOverdriveSaturationName() {return juce::String("Overdrive Saturation");}
+auto getOverdriveCurveName() {return juce::String("Overdrive Curve");}
+auto getOverdrivePreToneName() {return juce::String("Overdrive Pre Tone Hz");}
+auto getOverdrivePostToneName() {return juce::String("Overdrive Post Tone Hz");}
+auto getOverdriveOversamplingName() {return juce::String("Overdrive Oversampling");}
 auto getOverdriveBypassName() {return juce::String("Overdrive Bypass");}
 
 auto getLadderFilterChoices()
@@ -42,6 +48,8 @@ auto getLadderFilterModeName() {return juce::String("Ladder Filter Mode");}
 auto getLadderFilterCutoffName() {return juce::String("Ladder Filter Cutoff Hz");}
 auto getLadderFilterResonanceName() {return juce::String("Ladder Filter Resonance");}
 auto getLadderFilterDriveName() {return juce::String("Ladder Filter Drive");}
+auto getLadderFilterOversamplingName() {return juce::String("Ladder Filter Oversampling");}
+auto getLadderFilterDynamicName() {return juce::String("Ladder Filter Dynamic %");}
 auto getLadderFilterBypassName() {return juce::String("Ladder Filter Bypass");}
 
 
@@ -59,12 +67,69 @@ auto getGeneralFilterModeName() {return juce::String("General Filter Mode");}
 auto getGeneralFilterFreqName() {return juce::String("General Filter Freq Hz");}
 auto getGeneralFilterQualityName() {return juce::String("General Filter Quality");}
 auto getGeneralFilterGainName() {return juce::String("General Filter Gain");}
+auto getGeneralFilterStagesName() {return juce::String("General Filter Stages");}
+auto getGeneralFilterDynamicName() {return juce::String("General Filter Dynamic %");}
 auto getGeneralFilterBypassName() {return juce::String("General Filter Bypass");}
 
+auto getDelayTimeName() {return juce::String("Delay Time Ms");}
+auto getDelaySyncName() {return juce::String("Delay Sync");}
+auto getDelayFeedbackName() {return juce::String("Delay Feedback %");}
+auto getDelayModeName() {return juce::String("Delay Mode");}
+auto getDelayLowCutName() {return juce::String("Delay Low Cut Hz");}
+auto getDelayHighCutName() {return juce::String("Delay High Cut Hz");}
+auto getDelayMixName() {return juce::String("Delay Mix %");}
+auto getDelayBypassName() {return juce::String("Delay Bypass");}
+
 auto getSelectedTabName() {return juce::String("Selected Tab");}
 
 auto getInputGainName() {return juce::String("Input Gain dB");}
 auto getOutputGainName() {return juce::String("Output Gain dB");}
+auto getGlobalMixName() {return juce::String("Global Mix %");}
+
+auto getLFORateName(size_t lfo) {return juce::String("LFO ") + juce::String(static_cast<int>(lfo) + 1) + " RateHz";}
+auto getLFOShapeName(size_t lfo) {return juce::String("LFO ") + juce::String(static_cast<int>(lfo) + 1) + " Shape";}
+auto getEnvelopeAttackName() {return juce::String("Envelope Attack Ms");}
+auto getEnvelopeReleaseName() {return juce::String("Envelope Release Ms");}
+auto getSequencerRateName() {return juce::String("Sequencer RateHz");}
+auto getSequencerStepName(size_t step) {return juce::String("Sequencer Step ") + juce::String(static_cast<int>(step) + 1) + " %";}
+auto getModulationSourceName(size_t slot) {return juce::String("Mod ") + juce::String(static_cast<int>(slot) + 1) + " Source";}
+auto getModulationDestinationName(size_t slot) {return juce::String("Mod ") + juce::String(static_cast<int>(slot) + 1) + " Destination";}
+auto getModulationDepthName(size_t slot) {return juce::String("Mod ") + juce::String(static_cast<int>(slot) + 1) + " Depth %";}
+
+//the smoothed params a modulation slot can target. Sessions save the index, so only ever append.
+juce::StringArray getModulationDestinationChoices()
+{
+    return
+    {
+        getPhaserRateName(),
+        getPhaserCenterFreqName(),
+        getPhaserDepthName(),
+        getPhaserFeedbackName(),
+        getPhaserMixName(),
+        getChorusRateName(),
+        getChorusDepthName(),
+        getChorusCenterDelayName(),
+        getChorusFeedbackName(),
+        getChorusMixName(),
+        getChorusSpreadName(),
+        getOverdriveSaturationName(),
+        getOverdrivePreToneName(),
+        getOverdrivePostToneName(),
+        getLadderFilterCutoffName(),
+        getLadderFilterResonanceName(),
+        getLadderFilterDriveName(),
+        getGeneralFilterFreqName(),
+        getGeneralFilterQualityName(),
+        getGeneralFilterGainName(),
+        getDelayFeedbackName(),
+        getDelayLowCutName(),
+        getDelayHighCutName(),
+        getDelayMixName(),
+        getInputGainName(),
+        getOutputGainName(),
+        getGlobalMixName(),
+    };
+}
 
 //==============================================================================
 Project13AudioProcessor::Project13AudioProcessor()
@@ -85,7 +150,10 @@ Project13AudioProcessor::Project13AudioProcessor()
         dspOrder[i] = static_cast<DSP_Option>(i);
     }
     
-    restoreDspOrderFifo.push(dspOrder);
+    requestedGraph = {dspOrder, dspRouting};
+    
+    //the first editor builds its tabs from this, even if the audio thread never runs
+    events.push({DSP_Command::Type::Sync, 0, 0, {dspOrder, dspRouting}});
     
     //============ FLOAT PARAMS ============
     auto floatParams = std::array
@@ -103,23 +171,36 @@ Project13AudioProcessor::Project13AudioProcessor()
         &chorusCenterDelayms,
         &chorusFeedbackPercent,
         &chorusMixPercent,
+        &chorusSpreadPercent,
         
         //      OD
         &overdriveSaturation,
+        &overdrivePreToneHz,
+        &overdrivePostToneHz,
         
         //       LADDER FILTER
         &ladderFilterCutoffHz,
         &ladderFilterResonance,
         &ladderFilterDrive,
+        &ladderFilterDynamicPercent,
         
         //        GENERAL FILTER
         &generalFilterFreqHz,
         &generalFilterQuality,
         &generalFilterGain,
+        &generalFilterDynamicPercent,
+        
+        //        DELAY
+        &delayTimeMs,
+        &delayFeedbackPercent,
+        &delayLowCutHz,
+        &delayHighCutHz,
+        &delayMixPercent,
         
         //      IN OUT Gain
         &inputGain,
         &outputGain,
+        &globalMixPercent,
     };
     
     auto floatNameFuncs = std::array
@@ -137,23 +218,36 @@ Project13AudioProcessor::Project13AudioProcessor()
         &getChorusCenterDelayName,
         &getChorusFeedbackName,
         &getChorusMixName,
+        &getChorusSpreadName,
         
         //        OD
         &getOverdriveSaturationName,
+        &getOverdrivePreToneName,
+        &getOverdrivePostToneName,
         
         //        LADDER FILTER
         &getLadderFilterCutoffName,
         &getLadderFilterResonanceName,
         &getLadderFilterDriveName,
+        &getLadderFilterDynamicName,
         
         //        GENERAL FILTER
         &getGeneralFilterFreqName,
         &getGeneralFilterQualityName,
         &getGeneralFilterGainName,
+        &getGeneralFilterDynamicName,
+        
+        //        DELAY
+        &getDelayTimeName,
+        &getDelayFeedbackName,
+        &getDelayLowCutName,
+        &getDelayHighCutName,
+        &getDelayMixName,
         
         //      IN OUT Gain
         &getInputGainName,
         &getOutputGainName,
+        &getGlobalMixName,
         
     };
     
@@ -165,6 +259,11 @@ Project13AudioProcessor::Project13AudioProcessor()
     {
         &ladderFilterMode,
         &generalFilterMode,
+        &overdriveOversampling,
+        &ladderFilterOversampling,
+        &overdriveCurve,
+        &delaySync,
+        &delayMode,
         
     };
     
@@ -172,6 +271,11 @@ Project13AudioProcessor::Project13AudioProcessor()
     {
         &getLadderFilterModeName,
         &getGeneralFilterModeName,
+        &getOverdriveOversamplingName,
+        &getLadderFilterOversamplingName,
+        &getOverdriveCurveName,
+        &getDelaySyncName,
+        &getDelayModeName,
     };
     
     
@@ -185,6 +289,7 @@ Project13AudioProcessor::Project13AudioProcessor()
         &overdriveBypass,
         &ladderFilterBypass,
         &generalFilterBypass,
+        &delayBypass,
     };
     
     auto bypassNameFuncs = std::array
@@ -194,6 +299,7 @@ Project13AudioProcessor::Project13AudioProcessor()
         &getOverdriveBypassName,
         &getLadderFilterBypassName,
         &getGeneralFilterBypassName,
+        &getDelayBypassName,
     };
     
     initCachedParams<juce::AudioParameterBool*>(bypassParams, bypassNameFuncs);
@@ -201,18 +307,68 @@ Project13AudioProcessor::Project13AudioProcessor()
     //============ INT PARAMS ============
     auto intParams = std::array
     {
+        &chorusVoices,
+        &generalFilterStages,
         &selectedTab,
     };
     
     auto intNameFuncs = std::array
     {
+        &getChorusVoicesName,
+        &getGeneralFilterStagesName,
         &getSelectedTabName,
     };
     
     initCachedParams<juce::AudioParameterInt*>(intParams, intNameFuncs);
+    
+    //============ MODULATION PARAMS ============
+    auto getParam = [this]<typename ParamType>(ParamType*& param, const juce::String& name)
+    {
+        param = dynamic_cast<ParamType*>(apvts.getParameter(name));
+        jassert(param != nullptr);
+    };
+    
+    for (size_t i = 0; i < ModulationSources::NumLFOs; ++i)
+    {
+        getParam(lfoRateHz[i], getLFORateName(i));
+        getParam(lfoShape[i], getLFOShapeName(i));
+    }
+    
+    getParam(envelopeAttackMs, getEnvelopeAttackName());
+    getParam(envelopeReleaseMs, getEnvelopeReleaseName());
+    getParam(sequencerRateHz, getSequencerRateName());
+    
+    for (size_t i = 0; i < ModulationSources::NumSteps; ++i)
+        getParam(sequencerStepPercent[i], getSequencerStepName(i));
+    
+    for (size_t i = 0; i < NumModulationSlots; ++i)
+    {
+        getParam(modulationSource[i], getModulationSourceName(i));
+        getParam(modulationDestination[i], getModulationDestinationName(i));
+        getParam(modulationDepthPercent[i], getModulationDepthName(i));
+    }
+    
+    initSmootherBindings();
+    
+    auto destinations = getModulationDestinationChoices();
+    jassert(destinations.size() == static_cast<int>(NumSmoothedParams));
+    for (size_t i = 0; i < NumSmoothedParams; ++i)
+    {
+        auto binding = bindingForParameter[static_cast<size_t>(apvts.getParameter(destinations[static_cast<int>(i)])->getParameterIndex())];
+        jassert(binding >= 0);
+        modulationDestinationBindings[i] = static_cast<size_t>(binding);
+    }
+    
+    dynamicFilterRoutes =
+    {{
+        {ladderFilterDynamicPercent, static_cast<size_t>(bindingForParameter[static_cast<size_t>(ladderFilterCutoffHz->getParameterIndex())])},
+        {generalFilterDynamicPercent, static_cast<size_t>(bindingForParameter[static_cast<size_t>(generalFilterFreqHz->getParameterIndex())])},
+    }};
 }
 Project13AudioProcessor::~Project13AudioProcessor()
 {
+    for (auto& binding : smootherBindings)
+        binding.param->removeListener(this);
 }
 
 //==============================================================================
@@ -250,7 +406,60 @@ bool Project13AudioProcessor::isMidiEffect() const
 
 double Project13AudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return computeTailSeconds();
+}
+
+double Project13AudioProcessor::computeTailSeconds() const
+{
+    //how long each feedback loop or resonance takes to fall by TailDecayDb. Stages can feed each other, so the tails add up.
+    const auto decay = juce::Decibels::decibelsToGain(-TailDecayDb);
+    
+    //the first pass through the loop, then however many trips round it it takes to lose TailDecayDb
+    auto loopTail = [decay](double periodSeconds, double feedback)
+    {
+        feedback = juce::jmin(std::abs(feedback), MaxTailFeedback);
+        auto trips = feedback > 0.0 ? std::log(decay) / std::log(feedback) : 0.0;
+        return periodSeconds * (1.0 + trips);
+    };
+    
+    //a resonance of quality q at hz rings with an envelope time constant of q / (pi * hz)
+    auto resonanceTail = [decay](double hz, double q)
+    {
+        return -std::log(decay) * q / (juce::MathConstants<double>::pi * hz);
+    };
+    
+    double tail = 0.0;
+    
+    //the phaser's feedback goes round the allpass chain, which delays it by about a cycle of the centre frequency
+    if (phaserBypass->get() == false)
+        tail += loopTail(1.0 / phaserCenterFreqhz->get(), phaserFeedbackPercent->get() * 0.01);
+    
+    if (chorusBypass->get() == false)
+        tail += loopTail(chorusCenterDelayms->get() * 0.001, chorusFeedbackPercent->get() * 0.01);
+    
+    //the ladder self-oscillates at 100% resonance
+    if (ladderFilterBypass->get() == false)
+    {
+        auto resonance = juce::jmin(ladderFilterResonance->get() * 0.01, MaxTailFeedback);
+        tail += resonanceTail(ladderFilterCutoffHz->get(), 0.5 / (1.0 - resonance));
+    }
+    
+    if (generalFilterBypass->get() == false)
+        tail += generalFilterStages->get() * resonanceTail(generalFilterFreqHz->get(), generalFilterQuality->get());
+    
+    if (delayBypass->get() == false)
+    {
+        auto syncBeats = DelayEngine::getSyncBeats(delaySync->getIndex());
+        auto delaySeconds = syncBeats > 0.0 ? syncBeats * 60.0 / hostBpm.load() : delayTimeMs->get() * 0.001;
+        tail += loopTail(delaySeconds, delayFeedbackPercent->get() * 0.01);
+    }
+    
+    //a stage that was just bypassed fades out, and the oversampling filters delay everything
+    tail += BypassFader::FadeSeconds;
+    if (getSampleRate() > 0.0)
+        tail += getLatencySamples() / getSampleRate();
+    
+    return juce::jmin(tail, MaxTailSeconds);
 }
 
 int Project13AudioProcessor::getNumPrograms()
@@ -280,31 +489,102 @@ void Project13AudioProcessor::changeProgramName (int index, const juce::String&
 //==============================================================================
 void Project13AudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
+    const auto numChannels = static_cast<size_t>(getTotalNumInputChannels());
+    const auto numGroups = juce::jmax<size_t>(1, (numChannels + SIMDLanes::NumLanes - 1) / SIMDLanes::NumLanes);
+    
+    //the chains start in the bypass state of the params. A stage a Bypass command overrode keeps the override
+    //unless its param has changed since, as in processBlock(), so a re-prepare doesn't undo what the editor shows.
+    updateStageBypasses();
     
-    leftChannel.prepare(spec);
-    rightChannel.prepare(spec);
+    while (channelChains.size() < numGroups)
+    {
+        auto chain = std::make_unique<ChannelChainDSP>(*this);
+        chain->setOrder(dspOrder);
+        chain->setRouting(dspRouting);
+        channelChains.push_back(std::move(chain));
+    }
+    channelChains.resize(numGroups);
+    
+    for (size_t group = 0; group < numGroups; ++group)
+    {
+        juce::dsp::ProcessSpec spec;
+        spec.sampleRate = sampleRate;
+        spec.maximumBlockSize = samplesPerBlock;
+        spec.numChannels = static_cast<juce::uint32>(juce::jmin(SIMDLanes::NumLanes, numChannels - juce::jmin(numChannels, group * SIMDLanes::NumLanes)));
+        
+        channelChains[group]->setChannelSides(getLaneSides(getChannelLayoutOfBus(true, 0), group));
+        channelChains[group]->prepare(spec);
+    }
+    
+    latencyToReport.store(channelChains.front()->getLatencyInSamples());
+    setLatencySamples(latencyToReport.load());
+    
+    maxRampLength = juce::jmax(samplesPerBlock, 1);
+    rampIndices.allocate(static_cast<size_t>(maxRampLength), false);
+    for (int i = 0; i < maxRampLength; ++i)
+        rampIndices[i] = static_cast<float>(i + 1);
     
-    for(auto smoother : getSmoothers())
-        smoother->reset(sampleRate, 0.005);
+    for(auto& binding : smootherBindings)
+    {
+        binding.smoother->reset(sampleRate, 0.005);
+        binding.ramp->prepare(maxRampLength, rampIndices.get());
+    }
     
     updateSmootherFromParams(1, SmootherUpdateMode::initialize);
     
-    spec.numChannels = getTotalNumInputChannels();
+    modulationSources.prepare(sampleRate, maxRampLength);
+    modulationMatrix.prepare(maxRampLength);
+    
+    inputLevels.prepare(MaxChannels);
+    
+    //BS.1770 weights: side surrounds count 1.41 times, the LFE not at all
+    std::array<float, MaxChannels> loudnessWeights {};
+    const auto layout = getChannelLayoutOfBus(true, 0);
+    for (int ch = 0; ch < juce::jmin(layout.size(), MaxChannels); ++ch)
+    {
+        switch (layout.getTypeOfChannel(ch))
+        {
+            case juce::AudioChannelSet::LFE:
+            case juce::AudioChannelSet::LFE2:
+                loudnessWeights[static_cast<size_t>(ch)] = 0.f;
+                break;
+            case juce::AudioChannelSet::leftSurround:
+            case juce::AudioChannelSet::rightSurround:
+            case juce::AudioChannelSet::leftSurroundSide:
+            case juce::AudioChannelSet::rightSurroundSide:
+                loudnessWeights[static_cast<size_t>(ch)] = 1.41f;
+                break;
+            default:
+                loudnessWeights[static_cast<size_t>(ch)] = 1.f;
+                break;
+        }
+    }
+    outputMeter.prepare(sampleRate, loudnessWeights);
     
-    inputGainDSP.prepare(spec);
-    outputGainDSP.prepare(spec);
+    sleepState.reset();
+    gridStart = samplePosition;
     
+    analyzerBuffer.setSize(2, samplesPerBlock);
     leftSCSF.prepare(samplesPerBlock);
     rightSCSF.prepare(samplesPerBlock);
+    
+    //offline renders spread channel groups or parallel branches across a few threads. The caller is one
+    //of them. A section never has more branches than stages, and 7.1.4 makes at most three groups.
+    auto numWorkers = juce::jmin(juce::SystemStats::getNumCpus(), static_cast<int>(NumDSPOptions)) - 1;
+    if (useWorkerThreads && isNonRealtime() && numWorkers > 0)
+    {
+        if (workers == nullptr || workers->getNumThreads() != numWorkers + 1)
+            workers = std::make_unique<WorkStealingPool>(numWorkers);
+    }
+    else
+    {
+        workers.reset();
+    }
 }
 
-void Project13AudioProcessor::updateSmootherFromParams(int numSamplesToSkip, SmootherUpdateMode init)
+void Project13AudioProcessor::initSmootherBindings()
 {
-    auto paramsNeedingSmoothing = std::vector
+    auto params = std::array
     {
         phaserRatehz,
         phaserCenterFreqhz,
@@ -316,37 +596,26 @@ void Project13AudioProcessor::updateSmootherFromParams(int numSamplesToSkip, Smo
         chorusCenterDelayms,
         chorusFeedbackPercent,
         chorusMixPercent,
+        chorusSpreadPercent,
         overdriveSaturation,
+        overdrivePreToneHz,
+        overdrivePostToneHz,
         ladderFilterCutoffHz,
         ladderFilterResonance,
         ladderFilterDrive,
         generalFilterFreqHz,
         generalFilterQuality,
         generalFilterGain,
+        delayFeedbackPercent,
+        delayLowCutHz,
+        delayHighCutHz,
+        delayMixPercent,
         inputGain,
         outputGain,
+        globalMixPercent,
     };
     
-    auto smoothers = getSmoothers();
-    jassert(smoothers.size() == paramsNeedingSmoothing.size());
-    
-    for (size_t i = 0; i < smoothers.size(); ++i)
-    {
-        auto smoother = smoothers[i];
-        auto param = paramsNeedingSmoothing [i];
-        
-        if (init == SmootherUpdateMode::initialize)
-            smoother->setCurrentAndTargetValue(param->get());
-        else
-            smoother->setTargetValue(param->get());
-        
-        smoother->skip(numSamplesToSkip);
-    }
-}
-
-std::vector<juce::SmoothedValue<float>*> Project13AudioProcessor::getSmoothers()
-{
-    auto smoothers = std::vector
+    auto smoothers = std::array
     {
         &phaserRatehzSmoother,
         &phaserCenterFreqhzSmoother,
@@ -358,45 +627,388 @@ std::vector<juce::SmoothedValue<float>*> Project13AudioProcessor::getSmoothers()
         &chorusCenterDelaymsSmoother,
         &chorusFeedbackPercentSmoother,
         &chorusMixPercentSmoother,
+        &chorusSpreadPercentSmoother,
         &overdriveSaturationSmoother,
+        &overdrivePreToneHzSmoother,
+        &overdrivePostToneHzSmoother,
         &ladderFilterCutoffHzSmoother,
         &ladderFilterResonanceSmoother,
         &ladderFilterDriveSmoother,
         &generalFilterFreqHzSmoother,
         &generalFilterQualitySmoother,
         &generalFilterGainSmoother,
+        &delayFeedbackPercentSmoother,
+        &delayLowCutHzSmoother,
+        &delayHighCutHzSmoother,
+        &delayMixPercentSmoother,
         &inputGainSmoother,
         &outputGainSmoother,
+        &globalMixPercentSmoother,
+    };
+    
+    auto ramps = std::array
+    {
+        &phaserRatehzRamp,
+        &phaserCenterFreqhzRamp,
+        &phaserDepthPercentRamp,
+        &phaserFeedbackPercentRamp,
+        &phaserMixPercentRamp,
+        &chorusRatehzRamp,
+        &chorusDepthPercentRamp,
+        &chorusCenterDelaymsRamp,
+        &chorusFeedbackPercentRamp,
+        &chorusMixPercentRamp,
+        &chorusSpreadPercentRamp,
+        &overdriveSaturationRamp,
+        &overdrivePreToneHzRamp,
+        &overdrivePostToneHzRamp,
+        &ladderFilterCutoffHzRamp,
+        &ladderFilterResonanceRamp,
+        &ladderFilterDriveRamp,
+        &generalFilterFreqHzRamp,
+        &generalFilterQualityRamp,
+        &generalFilterGainRamp,
+        &delayFeedbackPercentRamp,
+        &delayLowCutHzRamp,
+        &delayHighCutHzRamp,
+        &delayMixPercentRamp,
+        &inputGainRamp,
+        &outputGainRamp,
+        &globalMixPercentRamp,
     };
     
-    return smoothers;
+    static_assert(std::tuple_size<decltype(params)>::value == NumSmoothedParams);
+    static_assert(std::tuple_size<decltype(smoothers)>::value == NumSmoothedParams);
+    static_assert(std::tuple_size<decltype(ramps)>::value == NumSmoothedParams);
+    
+    for (size_t i = 0; i < NumSmoothedParams; ++i)
+    {
+        jassert(params[i] != nullptr);
+        auto isGain = ramps[i] == &inputGainRamp || ramps[i] == &outputGainRamp;
+        smootherBindings[i] = { params[i], smoothers[i], ramps[i], isGain };
+    }
+    
+    bindingForParameter.assign(static_cast<size_t>(getParameters().size()), -1);
+    for (size_t i = 0; i < NumSmoothedParams; ++i)
+    {
+        bindingForParameter[static_cast<size_t>(params[i]->getParameterIndex())] = static_cast<int>(i);
+        params[i]->addListener(this);
+    }
+}
+
+thread_local juce::int64 Project13AudioProcessor::parameterChangePosition = DSP_Command::Immediately;
+
+void Project13AudioProcessor::setParameterAt(juce::RangedAudioParameter& param, float newValue, juce::int64 samplePosition)
+{
+    const juce::ScopedValueSetter<juce::int64> stamp(parameterChangePosition, samplePosition);
+    param.setValueNotifyingHost(newValue);
+}
+
+void Project13AudioProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+    if (juce::isPositiveAndBelow(parameterIndex, static_cast<int>(bindingForParameter.size())) == false)
+        return;
+    
+    auto binding = bindingForParameter[static_cast<size_t>(parameterIndex)];
+    if (binding < 0)
+        return;
+    
+    //hosts apply their automation just before processBlock(), so it lands on the block's first sample
+    ParameterEvent event;
+    event.samplePosition = parameterChangePosition != DSP_Command::Immediately ? parameterChangePosition : getSamplePosition();
+    event.binding = binding;
+    event.value = smootherBindings[static_cast<size_t>(binding)].param->convertFrom0to1(newValue);
+    
+    if (parameterEvents.push(event) == false)
+        parameterEventsLost.store(true);
 }
 
-void Project13AudioProcessor::MonoChannelDSP::prepare(juce::dsp::ProcessSpec &spec)
+int Project13AudioProcessor::applyDueParameterEvents(int numSamples)
 {
-    jassert(spec.numChannels == 1);
-    std::vector<juce::dsp::ProcessorBase*> dsp
+    //an event was dropped, so the targets can't be trusted. Take every one from its param now.
+    if (parameterEventsLost.exchange(false))
     {
-        &phaser,
-        &chorus,
-        &overdrive,
-        &ladderFilter,
-        &generalFilter,
-    };
+        for (auto& binding : smootherBindings)
+            binding.smoother->setTargetValue(binding.param->get());
+    }
+    
+    ParameterEvent event;
+    while (numPendingParameterEvents < pendingParameterEvents.size() && parameterEvents.pop(event))
+        pendingParameterEvents[numPendingParameterEvents++] = event;
+    
+    auto nextEvent = numSamples;
+    size_t numKept = 0;
+    for (size_t i = 0; i < numPendingParameterEvents; ++i)
+    {
+        const auto& pending = pendingParameterEvents[i];
+        auto offset = pending.samplePosition - samplePosition;
+        if (offset <= 0)
+        {
+            smootherBindings[static_cast<size_t>(pending.binding)].smoother->setTargetValue(pending.value);
+            continue;
+        }
+        
+        if (offset < numSamples)
+            nextEvent = juce::jmin(nextEvent, static_cast<int>(offset));
+        pendingParameterEvents[numKept++] = pending;
+    }
+    numPendingParameterEvents = numKept;
+    
+    return nextEvent;
+}
+
+void Project13AudioProcessor::updateSmootherFromParams(int numSamples, SmootherUpdateMode init)
+{
+    for (size_t index = 0; index < NumSmoothedParams; ++index)
+    {
+        auto& binding = smootherBindings[index];
+        auto smoother = binding.smoother;
+        
+        //live, the targets come from parameter events. See applyDueParameterEvents().
+        if (init == SmootherUpdateMode::initialize)
+            smoother->setCurrentAndTargetValue(binding.param->get());
+        
+        auto toRampValue = [isGain = binding.rampHoldsGain](float value)
+        {
+            return isGain ? juce::Decibels::decibelsToGain(value) : value;
+        };
+        
+        auto modulation = init == SmootherUpdateMode::liveInRealTime ? modulationMatrix.getAmounts(index) : nullptr;
+        if (modulation != nullptr)
+        {
+            //the smoother's path, moved within the param's range, then converted
+            if (smoother->isSmoothing())
+            {
+                binding.ramp->fillFrom(*smoother, numSamples, [](float value) { return value; });
+            }
+            else
+            {
+                auto value = smoother->getTargetValue();
+                binding.ramp->fill(value, value, numSamples);
+            }
+            
+            const auto& range = binding.param->range;
+            binding.ramp->transform(numSamples, [&](float value, int i)
+            {
+                auto normalised = juce::jlimit(0.f, 1.f, range.convertTo0to1(value) + modulation[i]);
+                return toRampValue(range.convertFrom0to1(normalised));
+            });
+        }
+        else if (smoother->isSmoothing())
+        {
+            binding.ramp->fillFrom(*smoother, numSamples, toRampValue);
+        }
+        else
+        {
+            auto value = toRampValue(smoother->getTargetValue());
+            binding.ramp->fill(value, value, numSamples);
+        }
+    }
+}
+
+ModulationSources::Settings Project13AudioProcessor::getModulationSettings() const
+{
+    ModulationSources::Settings settings;
+    for (size_t i = 0; i < ModulationSources::NumLFOs; ++i)
+    {
+        settings.lfoRateHz[i] = lfoRateHz[i]->get();
+        settings.lfoShape[i] = static_cast<ModulationSources::Shape>(lfoShape[i]->getIndex());
+    }
+    
+    settings.envelopeAttackMs = envelopeAttackMs->get();
+    settings.envelopeReleaseMs = envelopeReleaseMs->get();
+    settings.sequencerRateHz = sequencerRateHz->get();
+    
+    for (size_t i = 0; i < ModulationSources::NumSteps; ++i)
+        settings.steps[i] = sequencerStepPercent[i]->get() * 0.01f;
+    
+    return settings;
+}
+
+void Project13AudioProcessor::updateModulation(const juce::AudioBuffer<float>& input, juce::int64 blockStart)
+{
+    const auto numSamples = input.getNumSamples();
+    
+    //the sources always run, so an LFO's phase doesn't depend on when it was first routed.
+    //The envelope's pieces are the block's only scan of the input, and the meters and sleep check reuse it.
+    inputLevels.beginBlock();
+    modulationSources.process(blockStart, numSamples, subBlockSize.load(), getModulationSettings(), [&](int start, int length)
+    {
+        return inputLevels.measure(input, start, length);
+    });
+    
+    modulationMatrix.clearRoutes();
+    for (size_t slot = 0; slot < NumModulationSlots; ++slot)
+    {
+        auto source = modulationSource[slot]->getIndex() - 1; //0 is "None"
+        auto destination = static_cast<size_t>(modulationDestination[slot]->getIndex());
+        if (source < 0 || destination >= NumSmoothedParams)
+            continue;
+        
+        modulationMatrix.addRoute(static_cast<ModulationSources::Source>(source), modulationDestinationBindings[destination], modulationDepthPercent[slot]->get() * 0.01f);
+    }
+    
+    //auto-wah: the envelope opens (or closes) the filter, with the envelope's attack and release
+    for (const auto& [amount, binding] : dynamicFilterRoutes)
+        modulationMatrix.addRoute(ModulationSources::Envelope, binding, amount->get() * 0.01f);
+    
+    modulationMatrix.process(modulationSources, numSamples);
+}
+
+void Project13AudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples(latencyToReport.load());
+    
+    std::vector<DSP_Command> handedOver;
+    {
+        const juce::ScopedLock lock(handOverLock);
+        handedOver.swap(handedOverCommands);
+    }
+    
+    //their graphs were already noted when they were handed over
+    for (const auto& command : handedOver)
+        queueCommand(command);
+}
+
+void Project13AudioProcessor::setSubBlockSize(int newSize)
+{
+    subBlockSize.store(juce::jlimit(8, 2048, newSize));
+}
+
+void Project13AudioProcessor::applyGainRamp(juce::AudioBuffer<float>& buffer, const ParameterRamp& gainRamp)
+{
+    const auto numSamples = buffer.getNumSamples();
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        if (gainRamp.isConstant())
+            juce::FloatVectorOperations::multiply(buffer.getWritePointer(ch), gainRamp[0], numSamples);
+        else
+            juce::FloatVectorOperations::multiply(buffer.getWritePointer(ch), gainRamp.get(), numSamples);
+    }
+}
+
+void Project13AudioProcessor::ChannelChainDSP::prepare(juce::dsp::ProcessSpec &spec)
+{
+    jassert(spec.numChannels <= SIMDLanes::NumLanes);
+    preparedSpec = spec;
+    
+    ladderFilter.prepare(spec);
+    ladderFilter.reset();
+    
+    phaser.prepare(spec.sampleRate);
+    chorus.prepare(spec.sampleRate);
+    phaserLanes.prepare(spec.maximumBlockSize);
+    chorusLanes.prepare(spec.maximumBlockSize);
+    
+    generalFilter.reset();
+    generalFilterLanes.prepare(spec.maximumBlockSize);
     
-    for (auto p : dsp)
+    overdrive.prepare(spec.sampleRate);
+    overdriveLanes.prepare(static_cast<size_t>(spec.maximumBlockSize) << StageOversampler::MaxOrder);
+    
+    const auto numChannels = static_cast<int>(spec.numChannels);
+    const auto maxBlockSize = static_cast<int>(spec.maximumBlockSize);
+    
+    for (auto* mixer : {&phaserMix, &chorusMix, &delayMix, &chainMix})
+        mixer->prepare(numChannels, maxBlockSize);
+    
+    delay.prepare(spec);
+    
+    filterMode = GeneralFilterMode::END_OF_LIST; //forces the coefficients to be recomputed for the new sample rate
+    
+    overdriveOversampler.prepare(spec);
+    ladderFilterOversampler.prepare(spec);
+    updateOversampling();
+    
+    //no path through the graph can have more latency than every oversampler at its slowest
+    auto maxLatency = static_cast<int>(std::ceil(overdriveOversampler.getMaxLatencyInSamples() + ladderFilterOversampler.getMaxLatencyInSamples()));
+    
+    for (auto& buffer : branchBuffers)
+        buffer.setSize(numChannels, maxBlockSize);
+    
+    for (auto& compensation : branchDelays)
+        compensation.prepare(numChannels, maxLatency, maxBlockSize);
+    
+    //stages start in their current bypass state instead of fading into it
+    const auto bypassed = getBypasses();
+    for (size_t i = 0; i < NumDSPOptions; ++i)
     {
-        p->prepare(spec);
-        p->reset();
+        bypassFaders[i].prepare(spec.sampleRate, numChannels, maxBlockSize);
+        bypassFaders[i].reset(bypassed[i]);
+        bypassDelays[i].prepare(numChannels, maxLatency, maxBlockSize);
     }
     
-    overdrive.dsp.setCutoffFrequencyHz(20000.f);
+    chainDryDelay.prepare(numChannels, maxLatency, maxBlockSize);
+    needsUpdate = true;
+}
+
+void Project13AudioProcessor::ChannelChainDSP::setChannelSides(const LaneSides& sides)
+{
+    phaser.setChannelSides(sides);
+    chorus.setChannelSides(sides);
+    delay.setChannelSides(sides);
+}
+
+void Project13AudioProcessor::ChannelChainDSP::updateOversampling()
+{
+    updateOversampling(DSP_Option::Overdrive);
+    updateOversampling(DSP_Option::LadderFilter);
+}
+
+void Project13AudioProcessor::ChannelChainDSP::updateOversampling(DSP_Option option)
+{
+    if (option == DSP_Option::Overdrive && overdriveOversampler.setChoice(p.overdriveOversampling->getIndex()))
+        overdrive.prepare(preparedSpec.sampleRate * static_cast<double>(overdriveOversampler.getFactor()));
+    
+    if (option == DSP_Option::LadderFilter && ladderFilterOversampler.setChoice(p.ladderFilterOversampling->getIndex()))
+    {
+        auto spec = preparedSpec;
+        spec.sampleRate *= static_cast<double>(ladderFilterOversampler.getFactor());
+        spec.maximumBlockSize *= static_cast<juce::uint32>(ladderFilterOversampler.getFactor());
+        
+        //same channel count as before, so this doesn't allocate. It clears the filter state.
+        ladderFilter.dsp.prepare(spec);
+    }
+}
+
+int Project13AudioProcessor::ChannelChainDSP::getStageLatency(DSP_Option option) const
+{
+    if (option == DSP_Option::Overdrive)
+        return juce::roundToInt(overdriveOversampler.getLatencyInSamples());
+    if (option == DSP_Option::LadderFilter)
+        return juce::roundToInt(ladderFilterOversampler.getLatencyInSamples());
+    return 0;
+}
+
+int Project13AudioProcessor::ChannelChainDSP::getLaneLatency(const DSP_Routing::Lane& lane) const
+{
+    int latency = 0;
+    for (size_t i = 0; i < lane.numStages; ++i)
+        latency += getStageLatency(lane.stages[i]);
+    return latency;
+}
+
+int Project13AudioProcessor::ChannelChainDSP::getSectionLatency(const DSP_Routing::Section& section) const
+{
+    int latency = 0;
+    for (size_t i = 0; i < section.numLanes; ++i)
+        latency = juce::jmax(latency, getLaneLatency(section.lanes[i]));
+    return latency;
+}
+
+int Project13AudioProcessor::ChannelChainDSP::getLatencyInSamples() const
+{
+    int latency = 0;
+    for (size_t i = 0; i < plan.numSections; ++i)
+        latency += getSectionLatency(plan.sections[i]);
+    return latency;
 }
 
 void Project13AudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    workers.reset();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -406,12 +1018,10 @@ bool Project13AudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout from mono up to 7.1.4, including discrete ones.
+    // The channels are processed in SIMD groups, so none of them is special.
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+    if (numChannels < 1 || numChannels > MaxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -436,6 +1046,9 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13AudioProcessor::cre
     
     name = getOutputGainName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(-18.f, 18.f, 0.1f, 1.f), 0.f, "dB"));
+    
+    name = getGlobalMixName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f), 100.f, "%"));
 //  PHASER
     name = getPhaserRateName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(0.01f, 2.f, 0.01f, 1.f), 0.2f, "Hz"));
@@ -471,6 +1084,12 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13AudioProcessor::cre
     name = getChorusMixName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f), 0.f, "%"));
     
+    name = getChorusVoicesName();
+    layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID(name, versionHint), name, 1, static_cast<int>(ChorusEngine::MaxVoices), 1));
+    
+    name = getChorusSpreadName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f), 0.f, "%"));
+    
     name = getChorusBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID(name, versionHint), name, false));
     
@@ -478,6 +1097,18 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13AudioProcessor::cre
     name = getOverdriveSaturationName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(1.f, 100.f, 0.01f, 1.f), 1.f, ""));
     
+    name = getOverdriveCurveName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(name, versionHint), name, WaveshaperOverdrive::getCurveChoices(), 0));
+    
+    name = getOverdrivePreToneName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(WaveshaperOverdrive::MinPreToneHz, 1000.f, 1.f, 1.f), WaveshaperOverdrive::MinPreToneHz, "Hz"));
+    
+    name = getOverdrivePostToneName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(1000.f, WaveshaperOverdrive::MaxPostToneHz, 1.f, 1.f), WaveshaperOverdrive::MaxPostToneHz, "Hz"));
+    
+    name = getOverdriveOversamplingName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(name, versionHint), name, StageOversampler::getChoices(), 0));
+    
     name = getOverdriveBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID(name, versionHint), name, false));
     
@@ -495,6 +1126,12 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13AudioProcessor::cre
     name = getLadderFilterDriveName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(1.f, 100.f, 0.01f, 1.f), 1.f,""));
     
+    name = getLadderFilterOversamplingName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(name, versionHint), name, StageOversampler::getChoices(), 0));
+    
+    name = getLadderFilterDynamicName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(-100.f, 100.f, 0.1f, 1.f), 0.f, "%"));
+    
     name = getLadderFilterBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID(name, versionHint), name, false));
     
@@ -513,85 +1150,239 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13AudioProcessor::cre
     name = getGeneralFilterGainName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f), 0.f, "dB"));
     
+    name = getGeneralFilterStagesName();
+    layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID(name, versionHint), name, 1, static_cast<int>(ChannelChainDSP::MaxGeneralFilterStages), 1));
+    
+    name = getGeneralFilterDynamicName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(-100.f, 100.f, 0.1f, 1.f), 0.f, "%"));
+    
     name = getGeneralFilterBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID(name, versionHint), name, false));
     
-    name = getSelectedTabName();
-    layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID(name, versionHint), name, 0, static_cast<int>(DSP_Option::END_OF_LIST) - 1, static_cast<int>(DSP_Option::Chorus)));
+//    DELAY
+    name = getDelayTimeName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(DelayEngine::MinDelayMs, DelayEngine::MaxDelaySeconds * 1000.f, 1.f, 1.f), 250.f, "ms"));
     
-    return layout;
-}
-
-void Project13AudioProcessor::MonoChannelDSP::updateDSPFromParams()
-{
-    phaser.dsp.setRate(p.phaserRatehzSmoother.getCurrentValue());
-    phaser.dsp.setCentreFrequency(p.phaserCenterFreqhzSmoother.getCurrentValue());
-    phaser.dsp.setDepth(p.phaserDepthPercentSmoother.getCurrentValue() * 0.01f);
-    phaser.dsp.setFeedback(p.phaserFeedbackPercentSmoother.getCurrentValue() * 0.01f);
-    phaser.dsp.setMix(p.phaserMixPercentSmoother.getCurrentValue() * 0.01f);
+    name = getDelaySyncName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(name, versionHint), name, DelayEngine::getSyncChoices(), 0));
     
-    chorus.dsp.setRate(p.chorusRatehzSmoother.getCurrentValue());;
-    chorus.dsp.setDepth(p.chorusDepthPercentSmoother.getCurrentValue() * 0.01f);
-    chorus.dsp.setCentreDelay(p.chorusCenterDelaymsSmoother.getCurrentValue());
-    chorus.dsp.setFeedback(p.chorusFeedbackPercentSmoother.getCurrentValue() * 0.01f);
-    chorus.dsp.setMix(p.chorusMixPercentSmoother.getCurrentValue() * 0.01f);
+    name = getDelayFeedbackName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(0.f, 95.f, 0.1f, 1.f), 35.f, "%"));
     
-    overdrive.dsp.setDrive(p.overdriveSaturationSmoother.getCurrentValue());
+    name = getDelayModeName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(name, versionHint), name, DelayEngine::getModeChoices(), 0));
     
-    ladderFilter.dsp.setMode(static_cast<juce::dsp::LadderFilterMode>(p.ladderFilterMode->getIndex()));
-    ladderFilter.dsp.setCutoffFrequencyHz(p.ladderFilterCutoffHzSmoother.getCurrentValue());
-    ladderFilter.dsp.setResonance(p.ladderFilterResonanceSmoother.getCurrentValue() * 0.01f);
-    ladderFilter.dsp.setDrive(p.ladderFilterDriveSmoother.getCurrentValue());
+    name = getDelayLowCutName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(DelayEngine::MinLowCutHz, 2000.f, 1.f, 1.f), DelayEngine::MinLowCutHz, "Hz"));
     
-//    UPDATE GENERAL FILTER COEFFs HERE
-    auto sampleRate = p.getSampleRate();
-    auto genMode = p.generalFilterMode->getIndex();
-    auto genHz = p.generalFilterFreqHz->get();
-    auto genQ = p.generalFilterQuality->get();
-    auto genGain = p.generalFilterGain->get();
+    name = getDelayHighCutName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(1000.f, DelayEngine::MaxHighCutHz, 1.f, 1.f), DelayEngine::MaxHighCutHz, "Hz"));
     
-    bool filterChanged = false;
-    filterChanged |= (filterFreq != genHz);
-    filterChanged |= (filterQ != genQ);
-    filterChanged |= (filterGain != genGain);
+    name = getDelayMixName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f), 30.f, "%"));
     
-    auto updatedMode = static_cast<GeneralFilterMode>(genMode);
-    filterChanged |= (filterMode != updatedMode);
+    //bypassed by default so sessions saved before the delay existed sound the same
+    name = getDelayBypassName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID(name, versionHint), name, true));
     
-    if (filterChanged)
+//    MODULATION
+    for (size_t i = 0; i < ModulationSources::NumLFOs; ++i)
     {
-        filterMode = updatedMode;
-        filterFreq = genHz;
-        filterQ = genQ;
-        filterGain = genGain;
+        name = getLFORateName(i);
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(0.01f, 20.f, 0.01f, 1.f), 1.f, "Hz"));
         
-        juce::dsp::IIR::Coefficients<float>::Ptr coefficients;
-        switch(filterMode)
-        {
-                
-            case GeneralFilterMode::Peak:
-                coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, filterFreq, filterQ, juce::Decibels::decibelsToGain(filterGain));
-                break;
-            case GeneralFilterMode::Bandpass:
-                coefficients = juce::dsp::IIR::Coefficients<float>::makeBandPass(sampleRate, filterFreq, filterQ);
-                break;
-            case GeneralFilterMode::Notch:
-                coefficients = juce::dsp::IIR::Coefficients<float>::makeNotch(sampleRate, filterFreq, filterQ);
-                break;
-            case GeneralFilterMode::Allpass:
-                coefficients = juce::dsp::IIR::Coefficients<float>::makeAllPass(sampleRate, filterFreq, filterQ);
-                break;
-            case GeneralFilterMode::END_OF_LIST:
-                jassertfalse;
-                break;
-        }
+        name = getLFOShapeName(i);
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(name, versionHint), name, ModulationSources::getShapeChoices(), 0));
+    }
+    
+    name = getEnvelopeAttackName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(0.1f, 500.f, 0.1f, 1.f), 10.f, "ms"));
+    
+    name = getEnvelopeReleaseName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(1.f, 2000.f, 1.f, 1.f), 150.f, "ms"));
+    
+    name = getSequencerRateName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(0.1f, 32.f, 0.01f, 1.f), 4.f, "Hz"));
+    
+    for (size_t i = 0; i < ModulationSources::NumSteps; ++i)
+    {
+        name = getSequencerStepName(i);
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(-100.f, 100.f, 0.1f, 1.f), 0.f, "%"));
+    }
+    
+    for (size_t i = 0; i < NumModulationSlots; ++i)
+    {
+        name = getModulationSourceName(i);
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(name, versionHint), name, ModulationSources::getSourceChoices(), 0));
         
-        if (coefficients != nullptr)
-        {
-            *generalFilter.dsp.coefficients = *coefficients;
-            generalFilter.reset();
-        }
+        name = getModulationDestinationName(i);
+        layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(name, versionHint), name, getModulationDestinationChoices(), 0));
+        
+        name = getModulationDepthName(i);
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(name, versionHint), name, juce::NormalisableRange<float>(-100.f, 100.f, 0.1f, 1.f), 0.f, "%"));
     }
+    
+    name = getSelectedTabName();
+    layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID(name, versionHint), name, 0, static_cast<int>(DSP_Option::END_OF_LIST) - 1, static_cast<int>(DSP_Option::Chorus)));
+    
+    return layout;
+}
+
+template <Project13AudioProcessor::DSP_Option Option>
+void Project13AudioProcessor::ChannelChainDSP::updateStage(size_t rampOffset)
+{
+    if (bypassFaders[static_cast<size_t>(Option)].isFullyBypassed())
+        return;
+    
+    //every stage only touches its own members, so stages on parallel branches can update concurrently
+    if constexpr (Option == DSP_Option::Phase)
+    {
+        phaser.setRate(p.phaserRatehzRamp[rampOffset]);
+        phaser.setCentreFrequency(p.phaserCenterFreqhzRamp[rampOffset]);
+        phaser.setDepth(p.phaserDepthPercentRamp[rampOffset] * 0.01f);
+        phaser.setFeedback(p.phaserFeedbackPercentRamp[rampOffset] * 0.01f);
+    }
+    else if constexpr (Option == DSP_Option::Chorus)
+    {
+        chorus.setRate(p.chorusRatehzRamp[rampOffset]);
+        chorus.setDepth(p.chorusDepthPercentRamp[rampOffset] * 0.01f);
+        chorus.setCentreDelay(p.chorusCenterDelaymsRamp[rampOffset]);
+        chorus.setFeedback(p.chorusFeedbackPercentRamp[rampOffset] * 0.01f);
+        chorus.setVoices(p.chorusVoices->get());
+        chorus.setSpread(p.chorusSpreadPercentRamp[rampOffset] * 0.01f);
+    }
+    else if constexpr (Option == DSP_Option::Overdrive)
+    {
+        //overdrive and ladder drive are read per sample from the ramps in processStage()
+        overdrive.setCurve(static_cast<OverdriveCurve>(p.overdriveCurve->getIndex()));
+        overdrive.setPreToneHz(p.overdrivePreToneHzRamp[rampOffset]);
+        overdrive.setPostToneHz(p.overdrivePostToneHzRamp[rampOffset]);
+    }
+    else if constexpr (Option == DSP_Option::LadderFilter)
+    {
+        ladderFilter.dsp.setMode(static_cast<juce::dsp::LadderFilterMode>(p.ladderFilterMode->getIndex()));
+        ladderFilter.dsp.setCutoffFrequencyHz(p.ladderFilterCutoffHzRamp[rampOffset]);
+        ladderFilter.dsp.setResonance(p.ladderFilterResonanceRamp[rampOffset] * 0.01f);
+    }
+    else if constexpr (Option == DSP_Option::Delay)
+    {
+        //the delay time isn't smoothed. The engine crossfades to each new time instead.
+        auto syncBeats = DelayEngine::getSyncBeats(p.delaySync->getIndex());
+        delay.setDelayMs(syncBeats > 0.0 ? syncBeats * 60000.0 / p.hostBpm : static_cast<double>(p.delayTimeMs->get()));
+        delay.setPingPong(p.delayMode->getIndex() == 1);
+        delay.setLowCutHz(p.delayLowCutHzRamp[rampOffset]);
+        delay.setHighCutHz(p.delayHighCutHzRamp[rampOffset]);
+    }
+    else if constexpr (Option == DSP_Option::GeneralFilter)
+    {
+//    UPDATE GENERAL FILTER COEFFs HERE
+        //designed from the smoothed values with no allocation, then ramped in by the cascade
+        //over the next sub-block. The filter state is never reset, so changes don't click.
+        auto sampleRate = p.getSampleRate();
+        auto genMode = p.generalFilterMode->getIndex();
+        auto genHz = p.generalFilterFreqHzRamp[rampOffset];
+        auto genQ = p.generalFilterQualityRamp[rampOffset];
+        auto genGain = p.generalFilterGainRamp[rampOffset];
+        auto genStages = p.generalFilterStages->get();
+        
+        bool filterChanged = false;
+        filterChanged |= (filterFreq != genHz);
+        filterChanged |= (filterQ != genQ);
+        filterChanged |= (filterGain != genGain);
+        filterChanged |= (filterStages != genStages);
+        
+        auto updatedMode = static_cast<GeneralFilterMode>(genMode);
+        filterChanged |= (filterMode != updatedMode);
+        
+        if (filterChanged)
+        {
+            filterMode = updatedMode;
+            filterFreq = genHz;
+            filterQ = genQ;
+            filterGain = genGain;
+            filterStages = genStages;
+            
+            //keep the cutoff below nyquist for low sample rates
+            auto freq = juce::jmin<double>(filterFreq, sampleRate * 0.49);
+            
+            BiquadCoefficients coefficients;
+            switch(filterMode)
+            {
+                    
+                case GeneralFilterMode::Peak:
+                    //split the gain across the stages so extra stages narrow the peak without boosting it further
+                    coefficients = BiquadDesign::makePeak(sampleRate, freq, filterQ, juce::Decibels::decibelsToGain(filterGain / static_cast<float>(filterStages)));
+                    break;
+                case GeneralFilterMode::Bandpass:
+                    coefficients = BiquadDesign::makeBandPass(sampleRate, freq, filterQ);
+                    break;
+                case GeneralFilterMode::Notch:
+                    coefficients = BiquadDesign::makeNotch(sampleRate, freq, filterQ);
+                    break;
+                case GeneralFilterMode::Allpass:
+                    coefficients = BiquadDesign::makeAllPass(sampleRate, freq, filterQ);
+                    break;
+                case GeneralFilterMode::END_OF_LIST:
+                    jassertfalse;
+                    break;
+            }
+            
+            generalFilter.setCoefficients(coefficients, static_cast<size_t>(filterStages));
+        }
+    }
+}
+
+template <Project13AudioProcessor::DSP_Option Option>
+void Project13AudioProcessor::ChannelChainDSP::resetStage()
+{
+    if constexpr (Option == DSP_Option::Phase)
+    {
+        phaser.reset();
+    }
+    else if constexpr (Option == DSP_Option::Chorus)
+    {
+        chorus.reset();
+    }
+    else if constexpr (Option == DSP_Option::Overdrive)
+    {
+        overdrive.reset();
+        overdriveOversampler.reset();
+    }
+    else if constexpr (Option == DSP_Option::LadderFilter)
+    {
+        ladderFilter.reset();
+        ladderFilterOversampler.reset();
+    }
+    else if constexpr (Option == DSP_Option::GeneralFilter)
+    {
+        generalFilter.reset();
+        filterMode = GeneralFilterMode::END_OF_LIST; //forces the coefficients to be set, and snapped to
+    }
+    else if constexpr (Option == DSP_Option::Delay)
+    {
+        delay.reset();
+    }
+}
+
+void Project13AudioProcessor::ChannelChainDSP::updateDSPFromParams(size_t rampOffset)
+{
+    updateOversampling();
+    
+    [&]<size_t... I>(std::index_sequence<I...>)
+    {
+        (updateStage<static_cast<DSP_Option>(I)>(rampOffset), ...);
+    }(std::make_index_sequence<NumDSPOptions>());
+}
+
+const std::array<Project13AudioProcessor::ChannelChainDSP::UpdateFn, Project13AudioProcessor::NumDSPOptions>& Project13AudioProcessor::ChannelChainDSP::getUpdateTable()
+{
+    //indexed by DSP_Option
+    static constexpr auto updateFns = []<size_t... I>(std::index_sequence<I...>)
+    {
+        return std::array<UpdateFn, NumDSPOptions> { &ChannelChainDSP::updateStage<static_cast<DSP_Option>(I)>... };
+    }(std::make_index_sequence<NumDSPOptions>());
+    
+    return updateFns;
 }
 
 std::vector<juce::RangedAudioParameter*> Project13AudioProcessor::getParamsForOption(DSP_Option option)
@@ -623,6 +1414,8 @@ std::vector<juce::RangedAudioParameter*> Project13AudioProcessor::getParamsForOp
                 chorusCenterDelayms,
                 chorusFeedbackPercent,
                 chorusMixPercent,
+                chorusVoices,
+                chorusSpreadPercent,
                 chorusBypass,
             };
         }
@@ -632,6 +1425,10 @@ std::vector<juce::RangedAudioParameter*> Project13AudioProcessor::getParamsForOp
             {
                 // OD
                 overdriveSaturation,
+                overdriveCurve,
+                overdrivePreToneHz,
+                overdrivePostToneHz,
+                overdriveOversampling,
                 overdriveBypass,
             };
         }
@@ -644,6 +1441,10 @@ std::vector<juce::RangedAudioParameter*> Project13AudioProcessor::getParamsForOp
                 ladderFilterCutoffHz,
                 ladderFilterResonance,
                 ladderFilterDrive,
+                ladderFilterOversampling,
+                ladderFilterDynamicPercent,
+                envelopeAttackMs,
+                envelopeReleaseMs,
                 ladderFilterBypass,
             };
         }
@@ -656,9 +1457,28 @@ std::vector<juce::RangedAudioParameter*> Project13AudioProcessor::getParamsForOp
                 generalFilterFreqHz,
                 generalFilterQuality,
                 generalFilterGain,
+                generalFilterStages,
+                generalFilterDynamicPercent,
+                envelopeAttackMs,
+                envelopeReleaseMs,
                 generalFilterBypass,
             };
         }
+        case DSP_Option::Delay:
+        {
+            return
+            {
+                // DELAY
+                delayTimeMs,
+                delaySync,
+                delayFeedbackPercent,
+                delayMode,
+                delayLowCutHz,
+                delayHighCutHz,
+                delayMixPercent,
+                delayBypass,
+            };
+        }
         case DSP_Option::END_OF_LIST:
             break;
     }
@@ -668,9 +1488,9 @@ std::vector<juce::RangedAudioParameter*> Project13AudioProcessor::getParamsForOp
 
 }
 
-void Project13AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void Project13AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
 {
-    juce::ScopedNoDenormals noDenormals;
+    RealtimeGuard::ScopedNoAllocation noAllocations;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -717,157 +1537,868 @@ void Project13AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, ju
     //[DONE]: restore selected tab when closing/opening window (no quit)
     //[DONE]: metering
     //[DONE]: prepare allDSP
-    //TODO: wet/dry knob [bonus]
-    //TODO: mono & stereo versions [mono is bonus]
-    //TODO: modulators [bonus]
-    //TODO: thread-safe filtering updating [bonus]
+    //[DONE]: wet/dry knob [bonus]
+    //[DONE]: mono & stereo versions [mono is bonus]
+    //[DONE]: modulators [bonus]
+    //[DONE]: thread-safe filtering updating [bonus]
     //TODO: pre/post filtering [bonus]
-    //TODO: delay module [bonus]
+    //[DONE]: delay module [bonus]
     
 
-    leftChannel.updateDSPFromParams();
-    rightChannel.updateDSPFromParams();
-    
-    auto newDSPOrder = DSP_Order();
-    
-    //try to pull
-    while (dspOrderFifo.pull(newDSPOrder))
+    //the tempo can't change inside a host block, so the play head is asked once for all its segments
+    if (auto* playHead = getPlayHead())
+        if (auto position = playHead->getPosition())
+            if (auto bpm = position->getBpm(); bpm.hasValue() && *bpm > 0.0)
+                hostBpm = *bpm;
+    
+    //the block is walked in segments, each ending where the next command or parameter change is due, so it
+    //takes effect on its own sample, or after maxRampLength, the most the ramps hold. Stretches without a
+    //change stay in one piece.
+    const auto numSamples = buffer.getNumSamples();
+    for (int offset = 0; offset < numSamples;)
     {
-#if VERIFY_BYPASS_FUNCTIONALITY
-        jassertfalse;
-#endif
+        updateStageBypasses();
+        
+        auto length = juce::jmin(maxRampLength, numSamples - offset);
+        length = juce::jmin(applyDueCommands(length), applyDueParameterEvents(length));
+        
+        juce::AudioBuffer<float> segment(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), offset, length);
+        processSegment(segment);
+        offset += length;
     }
-    
-    if (newDSPOrder != DSP_Order())
-        dspOrder = newDSPOrder;
-    
-    //When plugin is 1st loaded, if gui closed an reopened, the restoreDspOrderFifo is empty.
-    //restoreDspOrderFifo is populated when setStateInformation is called. An atomic is used as signal.
-    if (guiNeedsLatestDspOrder.compareAndSetBool(false, true))
-        restoreDspOrderFifo.push(dspOrder);
+}
+
+void Project13AudioProcessor::processSegment(juce::AudioBuffer<float>& buffer)
+{
+    //commands and parameter events are stamped on samplePosition, the grid counts from gridStart
+    const auto blockStart = samplePosition - gridStart;
+    samplePosition += buffer.getNumSamples();
+    publishedSamplePosition.store(samplePosition, std::memory_order_relaxed);
     
 //    auto block = juce::dsp::AudioBlock<float>(buffer);
 //    leftChannel.process(block.getSingleChannelBlock(0), dspOrder);
 //    rightChannel.process(block.getSingleChannelBlock(1), dspOrder);
     auto block = juce::dsp::AudioBlock<float>(buffer);
     
-    auto preCtx = juce::dsp::ProcessContextReplacing<float>(block);
+    const auto numSamples = buffer.getNumSamples();
     
-    inputGainSmoother.setTargetValue(inputGain -> get());
-    outputGainSmoother.setTargetValue(outputGain -> get());
-    inputGainDSP.setGainDecibels(inputGainSmoother.getNextValue());
-    inputGainDSP.process(preCtx);
+    //measures this segment's input as it runs the sources, so the sleep check below sees its onset
+    updateModulation(buffer, blockStart);
+    const auto asleep = sleepState.beginBlock(inputLevels.getPeak(), numSamples);
     
-    const auto numSamples = buffer.getNumSamples();
-    auto samplesRemaining = numSamples;
-    auto maxSamplesToProcess = juce::jmin(samplesRemaining, 64);
+    //the smoothers stopped being heard when the processor fell asleep, so a glide from there would be stale
+    if (sleepState.hasJustWoken())
+    {
+        for (auto& binding : smootherBindings)
+            binding.smoother->setCurrentAndTargetValue(binding.smoother->getTargetValue());
+    }
+    
+    //advance every smoother once for the whole block, modulated. Gains, mixes and drives read the ramps per sample.
+    updateSmootherFromParams(numSamples, SmootherUpdateMode::liveInRealTime);
+    
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), MaxChannels);
+    
+    //the input was measured before the gain, which scales it exactly unless the gain is mid-glide
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto& levels = inputLevels.getLevels(ch);
+        const auto gain = inputGainRamp[numSamples - 1];
+        meters.input[static_cast<size_t>(ch)] = { levels.getRMS() * gain, levels.peak * gain };
+    }
+    
+    //asleep: the input is still silent and the tail has died away, so the output is silence too
+    if (asleep)
+    {
+        buffer.clear();
+        meters.output = outputMeter.skipSilence(numSamples, numChannels);
+        meters.numChannels = numChannels;
+        meters.seconds = static_cast<float>(numSamples / getSampleRate());
+        pushMeterFrame(meters);
+        
+        pushToAnalyzer(buffer);
+        return;
+    }
+    
+    applyGainRamp(buffer, inputGainRamp);
+    
+    const auto maxSamplesToProcess = static_cast<size_t>(subBlockSize.load());
+    const auto numGroups = juce::jmin(channelChains.size(), (block.getNumChannels() + SIMDLanes::NumLanes - 1) / SIMDLanes::NumLanes);
+    
+    if (sleepState.hasJustWoken())
+    {
+        for (size_t group = 0; group < numGroups; ++group)
+            channelChains[group]->wake();
+    }
+    
+    //offline, each channel group is a task on the worker pool, or with a single group the branches of its
+    //parallel sections are. Either way every chain splits the block the same way as below.
+    if (workers != nullptr && isNonRealtime() && numGroups > 1)
+    {
+        workers->run(static_cast<int>(numGroups), [&](int group)
+        {
+            auto index = static_cast<size_t>(group);
+            channelChains[index]->processInSubBlocks(getChannelGroupBlock(block, index), blockStart, maxSamplesToProcess);
+        });
+    }
+    else if (workers != nullptr && isNonRealtime() && numGroups == 1 && channelChains.front()->canUseWorkers())
+    {
+        channelChains.front()->processWithWorkers(block, blockStart, maxSamplesToProcess, *workers);
+    }
+    else
+    {
+        for (size_t group = 0; group < numGroups; ++group)
+            channelChains[group]->processInSubBlocks(getChannelGroupBlock(block, group), blockStart, maxSamplesToProcess);
+    }
+    
+    //oversampling choices are picked up per sub-block. Tell the host if that moved the latency.
+    auto latency = channelChains.front()->getLatencyInSamples();
+    if (latency != latencyToReport.load())
+    {
+        latencyToReport.store(latency);
+        RealtimeGuard::ScopedAllowAllocation allowPosting; //posting to the message queue may grow it
+        triggerAsyncUpdate();
+    }
+    
+    applyGainRamp(buffer, outputGainRamp);
+    
+    meters.output = outputMeter.process(buffer, numChannels);
+    meters.numChannels = numChannels;
+    meters.seconds = static_cast<float>(numSamples / getSampleRate());
+    pushMeterFrame(meters);
     
-    leftPreRMS.set(buffer.getRMSLevel(0, 0, numSamples));
-    rightPreRMS.set(buffer.getRMSLevel(1, 0, numSamples));
+    if (sleepState.isCountingSilence())
+        sleepState.endBlock(outputMeter.getPeak(numChannels), static_cast<juce::int64>(computeTailSeconds() * getSampleRate()));
+    
+    pushToAnalyzer(buffer);
+}
+
+void Project13AudioProcessor::pushMeterFrame(const MeterFrame& frame)
+{
+    if (hasUnsentMeterFrame)
+    {
+        unsentMeterFrame.merge(frame);
+        hasUnsentMeterFrame = meterHistory.push(unsentMeterFrame) == false;
+        return;
+    }
+    
+    if (meterHistory.push(frame) == false)
+    {
+        unsentMeterFrame = frame;
+        hasUnsentMeterFrame = true;
+    }
+}
+
+void Project13AudioProcessor::MeterFrame::merge(const MeterFrame& next)
+{
+    const auto total = seconds + next.seconds;
+    auto mergeRMS = [&](float a, float b)
+    {
+        return total > 0.f ? std::sqrt((a * a * seconds + b * b * next.seconds) / total) : juce::jmax(a, b);
+    };
+    
+    numChannels = juce::jmax(numChannels, next.numChannels);
+    for (size_t ch = 0; ch < static_cast<size_t>(numChannels); ++ch)
+    {
+        auto& in = input[ch];
+        in.rms = mergeRMS(in.rms, next.input[ch].rms);
+        in.peak = juce::jmax(in.peak, next.input[ch].peak);
+        
+        auto& out = output.channels[ch];
+        const auto& nextOut = next.output.channels[ch];
+        out.rms = mergeRMS(out.rms, nextOut.rms);
+        out.peak = juce::jmax(out.peak, nextOut.peak);
+        out.truePeak = juce::jmax(out.truePeak, nextOut.truePeak);
+        out.momentaryLufs = nextOut.momentaryLufs;
+        out.shortTermLufs = nextOut.shortTermLufs;
+    }
+    
+    output.momentaryLufs = next.output.momentaryLufs;
+    output.shortTermLufs = next.output.shortTermLufs;
+    seconds = total;
+}
+
+Project13AudioProcessor::DSP_Command Project13AudioProcessor::DSP_Command::reorder(const DSP_Order& order, juce::int64 at)
+{
+    DSP_Command command;
+    command.type = Type::Reorder;
+    command.samplePosition = at;
+    command.graph.order = order;
+    return command;
+}
+
+Project13AudioProcessor::DSP_Command Project13AudioProcessor::DSP_Command::bypass(DSP_Option option, bool bypassed, juce::int64 at)
+{
+    DSP_Command command;
+    command.type = Type::Bypass;
+    command.samplePosition = at;
+    command.option = option;
+    command.bypassed = bypassed;
+    return command;
+}
+
+Project13AudioProcessor::DSP_Command Project13AudioProcessor::DSP_Command::presetSwap(const DSP_Graph& graph, juce::int64 at)
+{
+    DSP_Command command;
+    command.type = Type::PresetSwap;
+    command.samplePosition = at;
+    command.graph = graph;
+    return command;
+}
+
+Project13AudioProcessor::DSP_Command Project13AudioProcessor::DSP_Command::reset(juce::int64 at)
+{
+    DSP_Command command;
+    command.type = Type::Reset;
+    command.samplePosition = at;
+    return command;
+}
+
+Project13AudioProcessor::DSP_Command Project13AudioProcessor::DSP_Command::sync()
+{
+    return {};
+}
+
+juce::uint32 Project13AudioProcessor::sendCommand(DSP_Command command)
+{
+    auto id = pushCommand(command);
+    if (id != 0)
+        noteRequestedGraph(command);
+    return id;
+}
+
+juce::uint32 Project13AudioProcessor::pushCommand(DSP_Command command)
+{
+    command.id = nextCommandId.fetch_add(1, std::memory_order_relaxed);
+    return commands.push(command) ? command.id : 0;
+}
+
+void Project13AudioProcessor::noteRequestedGraph(const DSP_Command& command)
+{
+    const juce::ScopedLock lock(requestedGraphLock);
+    if (command.type == DSP_Command::Type::Reorder)
+        requestedGraph.order = command.graph.order;
+    else if (command.type == DSP_Command::Type::PresetSwap)
+        requestedGraph = command.graph;
+}
+
+Project13AudioProcessor::DSP_Graph Project13AudioProcessor::getRequestedGraph() const
+{
+    const juce::ScopedLock lock(requestedGraphLock);
+    return requestedGraph;
+}
+
+void Project13AudioProcessor::sendCommandFromMessageThread(const DSP_Command& command)
+{
+    noteRequestedGraph(command);
+    queueCommand(command);
+}
+
+void Project13AudioProcessor::queueCommand(const DSP_Command& command)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    
+    if (unsentCommands.empty() && pushCommand(command) != 0)
+        return;
+    
+    unsentCommands.push_back(command);
+    if (isTimerRunning() == false)
+        startTimer(10);
+}
+
+void Project13AudioProcessor::timerCallback()
+{
+    //in order, stopping at the first that still doesn't fit
+    auto firstUnsent = std::find_if(unsentCommands.begin(), unsentCommands.end(), [this](const auto& command)
+    {
+        return pushCommand(command) == 0;
+    });
+    unsentCommands.erase(unsentCommands.begin(), firstUnsent);
+    
+    if (unsentCommands.empty())
+        stopTimer();
+}
+
+void Project13AudioProcessor::sendCommandFromAnyThread(const DSP_Command& command)
+{
+    if (juce::MessageManager::existsAndIsCurrentThread())
+    {
+        sendCommandFromMessageThread(command);
+        return;
+    }
+    
+    noteRequestedGraph(command);
+    if (pushCommand(command) != 0)
+        return;
+    
+    {
+        const juce::ScopedLock lock(handOverLock);
+        handedOverCommands.push_back(command);
+    }
+    triggerAsyncUpdate();
+}
+
+void Project13AudioProcessor::reset()
+{
+    sendCommandFromAnyThread(DSP_Command::reset());
+}
+
+int Project13AudioProcessor::applyDueCommands(int numSamples)
+{
+    DSP_Command command;
+    while (numPendingCommands < pendingCommands.size() && commands.pop(command))
+        pendingCommands[numPendingCommands++] = command;
+    
+    //due commands are applied in the order they were sent. The rest keep their order too.
+    auto nextCommand = numSamples;
+    size_t numKept = 0;
+    for (size_t i = 0; i < numPendingCommands; ++i)
+    {
+        const auto& pending = pendingCommands[i];
+        auto offset = pending.samplePosition - samplePosition;
+        if (offset <= 0)
+        {
+            applyCommand(pending);
+            continue;
+        }
+        
+        if (offset < numSamples)
+            nextCommand = juce::jmin(nextCommand, static_cast<int>(offset));
+        pendingCommands[numKept++] = pending;
+    }
+    numPendingCommands = numKept;
+    
+    return nextCommand;
+}
+
+void Project13AudioProcessor::applyCommand(const DSP_Command& command)
+{
+    switch (command.type)
+    {
+        case DSP_Command::Type::Reorder:
+#if VERIFY_BYPASS_FUNCTIONALITY
+            jassertfalse;
+#endif
+            dspOrder = command.graph.order;
+            for (auto& chain : channelChains)
+                chain->setOrder(dspOrder);
+            break;
+        case DSP_Command::Type::Bypass:
+            if (auto index = static_cast<size_t>(command.option); index < NumDSPOptions)
+                stageBypasses[index] = command.bypassed;
+            break;
+        case DSP_Command::Type::PresetSwap:
+            dspOrder = command.graph.order;
+            dspRouting = command.graph.routing;
+            for (auto& chain : channelChains)
+            {
+                chain->setOrder(dspOrder);
+                chain->setRouting(dspRouting);
+            }
+            break;
+        case DSP_Command::Type::Reset:
+            for (auto& chain : channelChains)
+                chain->reset();
+            sleepState.reset();
+            modulationSources.reset();
+            outputMeter.reset();
+            gridStart = samplePosition;
+            break;
+        case DSP_Command::Type::Sync:
+            break;
+    }
+    
+    events.pushDroppingOldest({command.type, command.id, samplePosition, {dspOrder, dspRouting}});
+}
+
+Project13AudioProcessor::StageBypasses Project13AudioProcessor::getBypassParams() const
+{
+    return
+    {
+        phaserBypass->get(),
+        chorusBypass->get(),
+        overdriveBypass->get(),
+        ladderFilterBypass->get(),
+        generalFilterBypass->get(),
+        delayBypass->get(),
+    };
+}
+
+void Project13AudioProcessor::updateStageBypasses()
+{
+    //a param only overrides a Bypass command by changing
+    auto params = getBypassParams();
+    for (size_t i = 0; i < NumDSPOptions; ++i)
+    {
+        if (params[i] != lastParamBypasses[i])
+            stageBypasses[i] = params[i];
+    }
+    lastParamBypasses = params;
+}
+
+void Project13AudioProcessor::pushToAnalyzer(juce::AudioBuffer<float>& buffer)
+{
+    const auto numChannels = buffer.getNumChannels();
+    const auto numSamples = buffer.getNumSamples();
     
+    //the analyzer shows the front left and right. Mono is shown on both sides.
+    if (numChannels >= 2)
+    {
+        leftSCSF.update(buffer);
+        rightSCSF.update(buffer);
+    }
+    else if (numChannels == 1)
+    {
+        for (int ch = 0; ch < analyzerBuffer.getNumChannels(); ++ch)
+            analyzerBuffer.copyFrom(ch, 0, buffer, 0, 0, numSamples);
+        
+        juce::AudioBuffer<float> stereo(analyzerBuffer.getArrayOfWritePointers(), analyzerBuffer.getNumChannels(), numSamples);
+        leftSCSF.update(stereo);
+        rightSCSF.update(stereo);
+    }
+}
+
+juce::dsp::AudioBlock<float> Project13AudioProcessor::getChannelGroupBlock(const juce::dsp::AudioBlock<float>& block, size_t group)
+{
+    const auto firstChannel = group * SIMDLanes::NumLanes;
+    jassert(firstChannel < block.getNumChannels());
+    return block.getSubsetChannelBlock(firstChannel, juce::jmin(SIMDLanes::NumLanes, block.getNumChannels() - firstChannel));
+}
+
+
 
+void Project13AudioProcessor::ChannelChainDSP::processInSubBlocks(juce::dsp::AudioBlock<float> block, juce::int64 blockStart, size_t subBlockSize)
+{
+    auto samplesRemaining = block.getNumSamples();
+    const auto maxSamplesToProcess = juce::jmax<size_t>(1, subBlockSize);
+    
     size_t startSample = 0;
     while (samplesRemaining > 0)
     {
         /*
          figure out how many samples to process.
-         i.e. you have a buffer size of 72.
+         i.e. you have a buffer size of 72 starting on a multiple of 64.
          the first time the samplesToProcess will be 64, because we set maxSamplesToProcess to 64, and samplesRemaining =72.
-         the 2nd time smaplesToProcess will be 8 (72-64).
+         the 2nd time smaplesToProcess will be 8 (72-64). The next block then starts with 56 to get back onto the grid.
          */
         
-        auto samplesToProcess = juce::jmin(samplesRemaining, maxSamplesToProcess);
-        updateSmootherFromParams(samplesToProcess, SmootherUpdateMode::liveInRealTime);
+        const auto position = blockStart + static_cast<juce::int64>(startSample);
+        auto samplesToProcess = getSubBlockLength(position, maxSamplesToProcess, samplesRemaining);
         
-        leftChannel.updateDSPFromParams();
-        rightChannel.updateDSPFromParams();
+        if (isUpdatePoint(position, maxSamplesToProcess))
+        {
+            updateDSPFromParams(startSample);
+            needsUpdate = false;
+        }
         
         //creatre sub block form buffer
         auto subBlock = block.getSubBlock(startSample, samplesToProcess);
         
         // procces
-        leftChannel.process(subBlock.getSingleChannelBlock(0), dspOrder);
-        rightChannel.process(subBlock.getSingleChannelBlock(1), dspOrder);
+        process(subBlock, startSample);
         
         startSample += samplesToProcess;
         samplesRemaining -= samplesToProcess;
         
     }
+}
+
+void Project13AudioProcessor::ChannelChainDSP::setOrder(const DSP_Order& newOrder)
+{
+    order = newOrder;
     
-    auto postCtx = juce::dsp::ProcessContextReplacing<float>(block);
-    outputGainDSP.setGainDecibels(outputGainSmoother.getNextValue());
-    outputGainDSP.process(postCtx);
+    auto index = ChainPermutations::indexOf(order);
+    if (index >= 0)
+        processFn = getPermutationTable()[static_cast<size_t>(index)];
+    else
+        processFn = &processArbitraryOrder;
     
-    leftPostRMS.set(buffer.getRMSLevel(0, 0, numSamples));
-    rightPostRMS.set(buffer.getRMSLevel(1, 0, numSamples));
+    rebuildPlan();
+}
+
+void Project13AudioProcessor::ChannelChainDSP::setRouting(const DSP_Routing& newRouting)
+{
+    routing = newRouting;
+    rebuildPlan();
+}
+
+void Project13AudioProcessor::ChannelChainDSP::reset()
+{
+    [&]<size_t... I>(std::index_sequence<I...>)
+    {
+        (resetStage<static_cast<DSP_Option>(I)>(), ...);
+    }(std::make_index_sequence<NumDSPOptions>());
+    
+    const auto bypassed = getBypasses();
+    for (size_t i = 0; i < NumDSPOptions; ++i)
+    {
+        bypassFaders[i].reset(bypassed[i]);
+        bypassDelays[i].reset();
+        branchDelays[i].reset();
+    }
     
-    leftSCSF.update(buffer);
-    rightSCSF.update(buffer);
+    chainDryDelay.reset();
+    needsUpdate = true;
 }
 
+void Project13AudioProcessor::ChannelChainDSP::wake()
+{
+    //the new targets first, so the reset below snaps the stages' smoothers and coefficients to them
+    updateDSPFromParams(0);
+    reset();
+}
 
+void Project13AudioProcessor::ChannelChainDSP::rebuildPlan()
+{
+    plan = routing.makePlan(order);
+    
+    //branches may now hold different stages, so their history no longer lines up
+    for (auto& compensation : branchDelays)
+        compensation.reset();
+}
+
+Project13AudioProcessor::StageBypasses Project13AudioProcessor::ChannelChainDSP::getBypasses() const
+{
+    return p.stageBypasses;
+}
 
-void Project13AudioProcessor::MonoChannelDSP::process(juce::dsp::AudioBlock<float> block, const DSP_Order &dspOrder)
+void Project13AudioProcessor::ChannelChainDSP::process(juce::dsp::AudioBlock<float> block, size_t rampOffset)
 {
-    //covert dsporder in array of pointers
-    DSP_Pointers dspPointers;
-    dspPointers.fill({}); // previously dspPointers.fill(nullptr);
+    jassert(processFn != nullptr);
     
-    for (size_t i = 0; i < dspOrder.size(); ++i)
+    auto bypassed = getBypasses();
+    
+    chainMix.pushDry(block);
+    
+    //fully serial routing takes the generated function for the order
+    if (plan.isSerial())
     {
-        switch (dspOrder[i]) {
-            case DSP_Option::Phase:
-                dspPointers[i].processor = &phaser;
-                dspPointers[i].bypassed = p.phaserBypass->get();
-                break;
-            case DSP_Option::Chorus:
-                dspPointers[i].processor = &chorus;
-                dspPointers[i].bypassed = p.chorusBypass->get();
-                break;
-            case DSP_Option::Overdrive:
-                dspPointers[i].processor = &overdrive;
-                dspPointers[i].bypassed = p.overdriveBypass->get();
-                break;
-            case DSP_Option::LadderFilter:
-                dspPointers[i].processor = &ladderFilter;
-                dspPointers[i].bypassed = p.ladderFilterBypass->get();
-                break;
-            case DSP_Option::GeneralFilter:
-                dspPointers[i].processor = &generalFilter;
-                dspPointers[i].bypassed = p.generalFilterBypass->get();
-                break;
-            case DSP_Option::END_OF_LIST:
-                jassertfalse;
-                break;
+        auto context = Context(block);
+        processFn(*this, context, bypassed, rampOffset);
+    }
+    else
+    {
+        processGraph(block, bypassed, rampOffset);
+    }
+    
+    applyChainMix(block, rampOffset);
+}
+
+bool Project13AudioProcessor::ChannelChainDSP::canUseWorkers() const
+{
+    return plan.isSerial() == false && processFn != &processArbitraryOrder;
+}
+
+size_t Project13AudioProcessor::ChannelChainDSP::getSubBlockLength(juce::int64 position, size_t subBlockSize, size_t samplesRemaining)
+{
+    auto intoSubBlock = static_cast<size_t>(position % static_cast<juce::int64>(subBlockSize));
+    return juce::jmin(samplesRemaining, subBlockSize - intoSubBlock);
+}
+
+bool Project13AudioProcessor::ChannelChainDSP::isUpdatePoint(juce::int64 position, size_t subBlockSize) const
+{
+    return needsUpdate || position % static_cast<juce::int64>(subBlockSize) == 0;
+}
+
+void Project13AudioProcessor::ChannelChainDSP::processWithWorkers(juce::dsp::AudioBlock<float> block, juce::int64 blockStart, size_t subBlockSize, WorkStealingPool& workers)
+{
+    jassert(canUseWorkers() && subBlockSize > 0);
+    
+    //every update point in a block reads the same oversampling choices, so the latency can only move at the
+    //first one. Each side of it is done on its own, so the compensation delays see the latency process() does.
+    const auto numSamples = block.getNumSamples();
+    const auto firstUpdate = isUpdatePoint(blockStart, subBlockSize) ? 0 : getSubBlockLength(blockStart, subBlockSize, numSamples);
+    if (firstUpdate > 0 && firstUpdate < numSamples)
+    {
+        processSectionsWithWorkers(block.getSubBlock(0, firstUpdate), blockStart, 0, subBlockSize, workers);
+        processSectionsWithWorkers(block.getSubBlock(firstUpdate), blockStart + static_cast<juce::int64>(firstUpdate), firstUpdate, subBlockSize, workers);
+    }
+    else
+    {
+        processSectionsWithWorkers(block, blockStart, 0, subBlockSize, workers);
+    }
+    
+    needsUpdate = false;
+}
+
+void Project13AudioProcessor::ChannelChainDSP::processSectionsWithWorkers(juce::dsp::AudioBlock<float> block, juce::int64 blockStart, size_t rampOffset, size_t subBlockSize, WorkStealingPool& workers)
+{
+    chainMix.pushDry(block);
+    
+    //section by section instead of sub-block by sub-block. Each stage still sees the same
+    //updates and the same samples in the same order, as its state is its own.
+    for (size_t s = 0; s < plan.numSections; ++s)
+    {
+        const auto& section = plan.sections[s];
+        if (section.parallel == false)
+        {
+            processLaneInSubBlocks(section.lanes[0], block, blockStart, rampOffset, subBlockSize);
+            continue;
         }
+        
+        workers.run(static_cast<int>(section.numLanes), [&](int task)
+        {
+            auto laneIndex = static_cast<size_t>(task);
+            auto branchBlock = beginBranch(laneIndex, block);
+            processLaneInSubBlocks(section.lanes[laneIndex], branchBlock, blockStart, rampOffset, subBlockSize);
+        });
+        
+        //the section's latency is read across every lane, so only once none of them can still change it
+        for (size_t lane = 0; lane < section.numLanes; ++lane)
+            endBranch(section, lane, getBranchBlock(lane, block));
+        
+        sumBranches(section, block);
     }
     
-    //now process
-    auto context = juce::dsp::ProcessContextReplacing<float>(block);
+    applyChainMix(block, rampOffset);
+}
+
+void Project13AudioProcessor::ChannelChainDSP::applyChainMix(const juce::dsp::AudioBlock<float>& block, size_t rampOffset)
+{
+    //the dry copy is always delayed, even at 100% wet, so it has history when the mix moves
+    auto dry = chainMix.getDryBlock(block.getNumChannels(), block.getNumSamples());
+    chainDryDelay.setDelay(getLatencyInSamples());
+    chainDryDelay.process(dry);
+    
+    const auto& mixRamp = p.globalMixPercentRamp;
+    if (mixRamp.isConstant() == false || mixRamp[0] != 100.f)
+        chainMix.mixWet(block, mixRamp.get(rampOffset));
+}
+
+void Project13AudioProcessor::ChannelChainDSP::processGraph(juce::dsp::AudioBlock<float> block, const StageBypasses& bypassed, size_t rampOffset)
+{
+    for (size_t s = 0; s < plan.numSections; ++s)
+    {
+        const auto& section = plan.sections[s];
+        if (section.parallel == false)
+        {
+            auto context = Context(block);
+            processLane(section.lanes[0], context, bypassed, rampOffset);
+            continue;
+        }
+        
+        for (size_t lane = 0; lane < section.numLanes; ++lane)
+        {
+            auto branchBlock = beginBranch(lane, block);
+            auto context = Context(branchBlock);
+            processLane(section.lanes[lane], context, bypassed, rampOffset);
+            endBranch(section, lane, branchBlock);
+        }
+        
+        sumBranches(section, block);
+    }
+}
+
+juce::dsp::AudioBlock<float> Project13AudioProcessor::ChannelChainDSP::beginBranch(size_t laneIndex, const juce::dsp::AudioBlock<float>& input)
+{
+    auto branchBlock = getBranchBlock(laneIndex, input);
+    branchBlock.copyFrom(input);
+    return branchBlock;
+}
+
+void Project13AudioProcessor::ChannelChainDSP::endBranch(const DSP_Routing::Section& section, size_t laneIndex, const juce::dsp::AudioBlock<float>& branchBlock)
+{
+    const auto& lane = section.lanes[laneIndex];
+    auto& compensation = branchDelays[static_cast<size_t>(lane.stages[0])];
+    compensation.setDelay(getSectionLatency(section) - getLaneLatency(lane));
+    compensation.process(branchBlock);
+    
+    branchBlock.multiplyBy(lane.mix);
+}
+
+void Project13AudioProcessor::ChannelChainDSP::sumBranches(const DSP_Routing::Section& section, juce::dsp::AudioBlock<float>& block)
+{
+    //always in lane order, so the float sum doesn't depend on which branch finished first
+    block.clear();
+    for (size_t lane = 0; lane < section.numLanes; ++lane)
+        block.add(getBranchBlock(lane, block));
+}
+
+juce::dsp::AudioBlock<float> Project13AudioProcessor::ChannelChainDSP::getBranchBlock(size_t laneIndex, const juce::dsp::AudioBlock<float>& input)
+{
+    return juce::dsp::AudioBlock<float>(branchBuffers[laneIndex]).getSubsetChannelBlock(0, input.getNumChannels()).getSubBlock(0, input.getNumSamples());
+}
+
+void Project13AudioProcessor::ChannelChainDSP::processLane(const DSP_Routing::Lane& lane, Context& context, const StageBypasses& bypassed, size_t rampOffset)
+{
+    const auto& stageFns = getStageTable();
+    for (size_t i = 0; i < lane.numStages; ++i)
+    {
+        auto index = static_cast<size_t>(lane.stages[i]);
+        if (index < NumDSPOptions)
+            (this->*stageFns[index])(context, bypassed[index], rampOffset);
+        else
+            jassertfalse;
+    }
+}
+
+void Project13AudioProcessor::ChannelChainDSP::processLaneInSubBlocks(const DSP_Routing::Lane& lane, juce::dsp::AudioBlock<float> block, juce::int64 blockStart, size_t rampOffset, size_t subBlockSize)
+{
+    const auto& updateFns = getUpdateTable();
+    const auto numSamples = block.getNumSamples();
     
-    for (size_t i=0; i < dspPointers.size(); ++i)
+    //the same split as processInSubBlocks(). needsUpdate is only cleared once every lane is done.
+    size_t length = 0;
+    for (size_t start = 0; start < numSamples; start += length)
     {
-        if (dspPointers[i].processor != nullptr)
+        const auto position = blockStart + static_cast<juce::int64>(start);
+        length = getSubBlockLength(position, subBlockSize, numSamples - start);
+        
+        //what updateDSPFromParams() and process() pick up, for this lane's stages only
+        if (isUpdatePoint(position, subBlockSize))
         {
-            juce::ScopedValueSetter<bool> svs (context.isBypassed, dspPointers[i].bypassed);
-            
-#if VERIFY_BYPASS_FUNCTIONALITY
-            if (context.isBypassed)
+            for (size_t i = 0; i < lane.numStages; ++i)
             {
-                jassertfalse;
+                auto index = static_cast<size_t>(lane.stages[i]);
+                if (index < NumDSPOptions)
+                {
+                    updateOversampling(lane.stages[i]);
+                    (this->*updateFns[index])(rampOffset + start);
+                }
             }
-            
-            
+        }
+        
+        auto subBlock = block.getSubBlock(start, length);
+        auto context = Context(subBlock);
+        processLane(lane, context, getBypasses(), rampOffset + start);
+    }
+}
+
+template <Project13AudioProcessor::DSP_Option Option>
+void Project13AudioProcessor::ChannelChainDSP::processStage(Context& context, bool bypassed, size_t rampOffset)
+{
+    constexpr auto hasLatency = Option == DSP_Option::Overdrive || Option == DSP_Option::LadderFilter;
+    constexpr auto index = static_cast<size_t>(Option);
+    
+    auto& block = context.getOutputBlock();
+    auto& fader = bypassFaders[index];
+    fader.setBypassed(bypassed);
+    
+    //a bypassed stage that has faded out costs nothing, apart from holding its latency
+    if (fader.isFullyBypassed())
+    {
+#if VERIFY_BYPASS_FUNCTIONALITY
+        jassertfalse;
 #endif
-            if (dspPointers[i].processor == &generalFilter)
-            {
-                continue;
-            }
-            dspPointers[i].processor->process(context);
+        if constexpr (hasLatency)
+        {
+            bypassDelays[index].setDelay(getStageLatency(Option));
+            bypassDelays[index].process(block);
         }
+        return;
+    }
+    
+    if (fader.takeResume())
+    {
+        resetStage<Option>();
+        updateStage<Option>(rampOffset);
+    }
+    
+    const auto fading = fader.isFading();
+    if (fading || hasLatency)
+        fader.pushDry(block);
+    
+    if constexpr (hasLatency)
+    {
+        //keeps the delay's history current, so the dry side of a fade is in phase with the stage
+        bypassDelays[index].setDelay(getStageLatency(Option));
+        bypassDelays[index].process(fader.getDryBlock(block.getNumChannels(), block.getNumSamples()));
+    }
+    
+    //calls go straight to the concrete processors so the compiler can inline each stage.
+    if constexpr (Option == DSP_Option::Phase)
+    {
+        phaserMix.pushDry(block);
+        phaser.process(phaserLanes.interleave(block));
+        phaserLanes.deinterleave(block);
+        phaserMix.mixWet(block, p.phaserMixPercentRamp.get(rampOffset));
+    }
+    else if constexpr (Option == DSP_Option::Chorus)
+    {
+        chorusMix.pushDry(block);
+        chorus.process(chorusLanes.interleave(block));
+        chorusLanes.deinterleave(block);
+        chorusMix.mixWet(block, p.chorusMixPercentRamp.get(rampOffset));
+    }
+    else if constexpr (Option == DSP_Option::Overdrive)
+    {
+        auto* drive = p.overdriveSaturationRamp.get(rampOffset);
+        overdriveOversampler.process(context, [this, drive](const Context& oversampled)
+        {
+            auto& oversampledBlock = oversampled.getOutputBlock();
+            overdrive.process(overdriveLanes.interleave(oversampledBlock), drive, overdriveOversampler.getOrder());
+            overdriveLanes.deinterleave(oversampledBlock);
+        });
+    }
+    else if constexpr (Option == DSP_Option::LadderFilter)
+    {
+        auto* drive = p.ladderFilterDriveRamp.get(rampOffset);
+        ladderFilterOversampler.process(context, [this, drive](const Context& oversampled)
+        {
+            ladderFilter.dsp.processWithDrive(oversampled, drive, ladderFilterOversampler.getOrder());
+        });
+    }
+    else if constexpr (Option == DSP_Option::GeneralFilter)
+    {
+        generalFilter.process(generalFilterLanes.interleave(block));
+        generalFilterLanes.deinterleave(block);
+    }
+    else if constexpr (Option == DSP_Option::Delay)
+    {
+        delayMix.pushDry(block);
+        delay.process(block, p.delayFeedbackPercentRamp.get(rampOffset));
+        delayMix.mixWet(block, p.delayMixPercentRamp.get(rampOffset));
+    }
+    
+    if (fading)
+        fader.mix(block);
+}
+
+template <size_t PermutationIndex>
+void Project13AudioProcessor::ChannelChainDSP::processPermutation(ChannelChainDSP& chain, Context& context, const StageBypasses& bypassed, size_t rampOffset)
+{
+    static constexpr auto& stages = ChainPermutations::all<DSP_Option, NumDSPOptions>[PermutationIndex];
+    
+    [&]<size_t... I>(std::index_sequence<I...>)
+    {
+        (chain.processStage<stages[I]>(context, bypassed[static_cast<size_t>(stages[I])], rampOffset), ...);
+    }(std::make_index_sequence<NumDSPOptions>());
+}
+
+const std::array<Project13AudioProcessor::ChannelChainDSP::StageFn, Project13AudioProcessor::NumDSPOptions>& Project13AudioProcessor::ChannelChainDSP::getStageTable()
+{
+    //indexed by DSP_Option
+    static constexpr auto stageFns = []<size_t... I>(std::index_sequence<I...>)
+    {
+        return std::array<StageFn, NumDSPOptions> { &ChannelChainDSP::processStage<static_cast<DSP_Option>(I)>... };
+    }(std::make_index_sequence<NumDSPOptions>());
+    
+    return stageFns;
+}
+
+void Project13AudioProcessor::ChannelChainDSP::processArbitraryOrder(ChannelChainDSP& chain, Context& context, const StageBypasses& bypassed, size_t rampOffset)
+{
+    const auto& stageFns = getStageTable();
+    for (auto option : chain.order)
+    {
+        auto index = static_cast<size_t>(option);
+        if (index < NumDSPOptions)
+            (chain.*stageFns[index])(context, bypassed[index], rampOffset);
+        else
+            jassertfalse;
     }
 }
 
+const std::array<Project13AudioProcessor::ChannelChainDSP::ProcessFn, Project13AudioProcessor::ChannelChainDSP::NumPermutations>& Project13AudioProcessor::ChannelChainDSP::getPermutationTable()
+{
+    //one fully specialized process function per ordering of DSP_Option
+    static constexpr auto table = []<size_t... I>(std::index_sequence<I...>)
+    {
+        return std::array<ProcessFn, NumPermutations> { &processPermutation<I>... };
+    }(std::make_index_sequence<NumPermutations>());
+    
+    return table;
+}
+
 //==============================================================================
 bool Project13AudioProcessor::hasEditor() const
 {
@@ -883,12 +2414,15 @@ juce::AudioProcessorEditor* Project13AudioProcessor::createEditor()
 //==============================================================================
 
 template<>
-struct juce::VariantConverter<Project13AudioProcessor::DSP_Order>
+struct juce::VariantConverter<Project13AudioProcessor::DSP_Graph>
 {
-    static Project13AudioProcessor::DSP_Order fromVar (const juce::var& v)
+    //separates the order from the routing that follows it. Sessions saved before routing existed end after the order.
+    static constexpr int RoutingMarker = -1;
+    
+    static Project13AudioProcessor::DSP_Graph fromVar (const juce::var& v)
     {
-        using T = Project13AudioProcessor::DSP_Order;
-        T dspOrder;
+        Project13AudioProcessor::DSP_Graph graph;
+        auto& dspOrder = graph.order;
         
         jassert(v.isBinaryData());
         
@@ -903,26 +2437,64 @@ struct juce::VariantConverter<Project13AudioProcessor::DSP_Order>
             std::vector<int> arr;
             while (!mis.isExhausted())
             {
-                arr.push_back(mis.readInt());
+                auto value = mis.readInt();
+                if (value == RoutingMarker)
+                    break;
+                arr.push_back(value);
             }
             
-            jassert(arr.size() == dspOrder.size());
+            jassert(arr.size() <= dspOrder.size());
             
-            for(size_t i = 0; i<dspOrder.size(); ++i)
-                dspOrder[i] = static_cast<Project13AudioProcessor::DSP_Option>(arr[i]);
+            //orders saved before an option existed are shorter. Keep them and append the missing options.
+            dspOrder.fill(Project13AudioProcessor::DSP_Option::END_OF_LIST);
+            size_t size = 0;
+            for (auto value : arr)
+            {
+                if (size < dspOrder.size() && juce::isPositiveAndBelow(value, static_cast<int>(Project13AudioProcessor::NumDSPOptions)))
+                    dspOrder[size++] = static_cast<Project13AudioProcessor::DSP_Option>(value);
+            }
+            
+            for (size_t i = 0; i < dspOrder.size() && size < dspOrder.size(); ++i)
+            {
+                auto option = static_cast<Project13AudioProcessor::DSP_Option>(i);
+                if (std::find(dspOrder.begin(), dspOrder.begin() + size, option) == dspOrder.begin() + size)
+                    dspOrder[size++] = option;
+            }
+            
+            //the number of stages the routing was saved with, then a branch and a branch mix for each
+            auto& routing = graph.routing;
+            auto numSaved = mis.isExhausted() ? 0 : juce::jmax(0, mis.readInt());
+            for (int i = 0; i < numSaved && ! mis.isExhausted(); ++i)
+            {
+                auto branch = juce::jlimit(0, static_cast<int>(Project13AudioProcessor::DSP_Routing::MaxBranches), mis.readInt());
+                if (static_cast<size_t>(i) < routing.branches.size())
+                    routing.branches[static_cast<size_t>(i)] = branch;
+            }
+            for (int i = 0; i < numSaved && ! mis.isExhausted(); ++i)
+            {
+                auto mix = mis.readFloat();
+                if (static_cast<size_t>(i) < routing.branchMix.size())
+                    routing.branchMix[static_cast<size_t>(i)] = mix;
+            }
         }
-        return dspOrder;
+        return graph;
     }
     
-    static juce::var toVar(const Project13AudioProcessor::DSP_Order& t)
+    static juce::var toVar(const Project13AudioProcessor::DSP_Graph& t)
     {
         juce::MemoryBlock mb;
         //juce MOS uses scoping to complete writing
         {
             juce::MemoryOutputStream mos(mb, false);
-            for (const auto& v : t)
+            for (const auto& v : t.order)
                 mos.writeInt(static_cast<int>(v));
-
+            
+            mos.writeInt(RoutingMarker);
+            mos.writeInt(static_cast<int>(t.routing.branches.size()));
+            for (auto branch : t.routing.branches)
+                mos.writeInt(branch);
+            for (auto mix : t.routing.branchMix)
+                mos.writeFloat(mix);
         }
         return mb;
     }
@@ -931,7 +2503,9 @@ struct juce::VariantConverter<Project13AudioProcessor::DSP_Order>
 
 void Project13AudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    apvts.state.setProperty("dspOrder", juce::VariantConverter<Project13AudioProcessor::DSP_Order>::toVar(dspOrder), nullptr);
+    //dspOrder and dspRouting belong to the audio thread, and a command changing them may still be on its way
+    apvts.state.setProperty("dspOrder", juce::VariantConverter<Project13AudioProcessor::DSP_Graph>::toVar(getRequestedGraph()), nullptr);
+    apvts.state.setProperty("subBlockSize", getSubBlockSize(), nullptr);
     juce::MemoryOutputStream mos(destData, false);
     apvts.state.writeToStream(mos);
 }
@@ -945,10 +2519,12 @@ void Project13AudioProcessor::setStateInformation (const void* data, int sizeInB
         
         if(apvts.state.hasProperty("dspOrder"))
         {
-            auto order = juce::VariantConverter<Project13AudioProcessor::DSP_Order>::fromVar(apvts.state.getProperty("dspOrder"));
-            dspOrderFifo.push(order);
-            restoreDspOrderFifo.push(order);
+            auto graph = juce::VariantConverter<Project13AudioProcessor::DSP_Graph>::fromVar(apvts.state.getProperty("dspOrder"));
+            sendCommandFromAnyThread(DSP_Command::presetSwap(graph));
         }
+        
+        setSubBlockSize(apvts.state.getProperty("subBlockSize", DefaultSubBlockSize));
+        
         DBG(apvts.state.toXmlString());
         
 #if VERIFY_BYPASS_FUNCTIONALITY
@@ -958,7 +2534,7 @@ void Project13AudioProcessor::setStateInformation (const void* data, int sizeInB
             order.fill(DSP_Option::LadderFilter);
             order[0] = DSP_Option::Chorus;
             chorusBypass->setValueNotifyingHost(1.f);
-            dspOrderFifo.push(order);
+            sendCommandFromMessageThread(DSP_Command::reorder(order));
         });
         
 #endif
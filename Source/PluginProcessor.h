@@ -9,8 +9,29 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "Fifo.h"
 #include <SingleChannelSampleFifo.h>
+#include "DSP/RealtimeGuard.h"
+#include "DSP/ChainPermutations.h"
+#include "DSP/SIMDLanes.h"
+#include "DSP/BiquadCascade.h"
+#include "DSP/ParameterRamp.h"
+#include "DSP/RampedLadderFilter.h"
+#include "DSP/StageOversampler.h"
+#include "DSP/WaveshaperOverdrive.h"
+#include "DSP/ChorusEngine.h"
+#include "DSP/PhaserEngine.h"
+#include "DSP/DelayEngine.h"
+#include "DSP/RoutingGraph.h"
+#include "DSP/CompensationDelay.h"
+#include "DSP/DryWetBuffer.h"
+#include "DSP/WorkStealingPool.h"
+#include "DSP/BypassFader.h"
+#include "DSP/SleepState.h"
+#include "DSP/LevelDetector.h"
+#include "DSP/OutputMeter.h"
+#include "DSP/SPSCRing.h"
+#include "DSP/LockFreeQueue.h"
+#include "DSP/ModulationMatrix.h"
 
 static constexpr int NEGATIVE_INFINITY = -72;
 static constexpr int MAX_DECIBELS = 12;
@@ -26,7 +47,7 @@ enum class GeneralFilterMode
 //==============================================================================
 /**
 */
-class Project13AudioProcessor  : public juce::AudioProcessor
+class Project13AudioProcessor  : public juce::AudioProcessor, private juce::AsyncUpdater, private juce::Timer, private juce::AudioProcessorParameter::Listener
 {
     public:
     //==============================================================================
@@ -66,6 +87,9 @@ class Project13AudioProcessor  : public juce::AudioProcessor
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     
+    //clears every stage's state, via a Reset command so it happens on the audio thread
+    void reset() override;
+    
     enum class DSP_Option
     {
         Phase,
@@ -73,14 +97,85 @@ class Project13AudioProcessor  : public juce::AudioProcessor
         Overdrive,
         LadderFilter,
         GeneralFilter,
+        Delay,
         END_OF_LIST,
     };
     
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Settings", createParameterLayout()};
     
-    using DSP_Order = std::array<DSP_Option, static_cast<size_t>(DSP_Option::END_OF_LIST)>;
-    SimpleMBComp::Fifo<DSP_Order> dspOrderFifo, restoreDspOrderFifo;
+    static constexpr size_t NumDSPOptions = static_cast<size_t>(DSP_Option::END_OF_LIST);
+    using DSP_Order = std::array<DSP_Option, NumDSPOptions>;
+    
+    //which stages run on parallel branches and the branch mixes. Independent of the order.
+    using DSP_Routing = RoutingGraph<DSP_Option, NumDSPOptions>;
+    
+    //saved together in the "dspOrder" state property
+    struct DSP_Graph
+    {
+        DSP_Order order;
+        DSP_Routing routing;
+    };
+    
+    /*
+     Changes to the chain, sent to the audio thread with sendCommand(). A command is applied at
+     samplePosition on the timeline of getSamplePosition(): the block holding that sample is split
+     there. Immediately, or a position already passed, applies it at the start of the next block.
+     */
+    struct DSP_Command
+    {
+        enum class Type
+        {
+            Reorder,    //graph.order
+            Bypass,     //option and bypassed. The bypass param takes over again the next time it changes.
+            PresetSwap, //graph.order and graph.routing
+            Reset,      //clears every stage's state and restarts the modulation sources
+            Sync,       //changes nothing, only asks for a DSP_Event with the current graph
+        };
+        
+        static constexpr juce::int64 Immediately = -1;
+        
+        Type type = Type::Sync;
+        juce::int64 samplePosition = Immediately;
+        juce::uint32 id = 0; //assigned by sendCommand(). 0 is never used.
+        DSP_Graph graph;
+        DSP_Option option = DSP_Option::END_OF_LIST;
+        bool bypassed = false;
+        
+        static DSP_Command reorder(const DSP_Order& order, juce::int64 at = Immediately);
+        static DSP_Command bypass(DSP_Option option, bool bypassed, juce::int64 at = Immediately);
+        static DSP_Command presetSwap(const DSP_Graph& graph, juce::int64 at = Immediately);
+        static DSP_Command reset(juce::int64 at = Immediately);
+        static DSP_Command sync();
+    };
+    
+    //sent back by the audio thread for every command it applies, with the graph as it is afterwards
+    struct DSP_Event
+    {
+        DSP_Command::Type type = DSP_Command::Type::Sync;
+        juce::uint32 commandId = 0;
+        juce::int64 samplePosition = 0;
+        DSP_Graph graph;
+    };
+    
+    //any thread. Returns the id the acknowledging DSP_Event will carry, or 0 if the queue is full
+    //because the audio thread has stopped pulling commands. Nothing is dropped to make room.
+    juce::uint32 sendCommand(DSP_Command command);
+    
+    //message thread only. Sends the command now if there is room and no earlier one is still waiting,
+    //otherwise keeps it and retries on a timer, so it is applied late but never lost or reordered.
+    void sendCommandFromMessageThread(const DSP_Command& command);
+    
+    //a single consumer, normally the editor on the message thread. Returns false once the queue is empty.
+    //Nobody may be draining it, so it keeps only the newest events.
+    bool pullEvent(DSP_Event& event) { return events.pop(event); }
+    
+    //the next sample the audio thread will process, for timestamping commands
+    juce::int64 getSamplePosition() const { return publishedSamplePosition.load(std::memory_order_relaxed); }
+    
+    //setValueNotifyingHost(), with the change to a smoothed param landing on samplePosition instead of the
+    //next block's first sample, like sample-accurate host automation. Other params change immediately.
+    void setParameterAt(juce::RangedAudioParameter& param, float newValue, juce::int64 samplePosition);
     
     
     //  Phase
@@ -96,22 +191,41 @@ class Project13AudioProcessor  : public juce::AudioProcessor
     juce::AudioParameterFloat* chorusCenterDelayms = nullptr;
     juce::AudioParameterFloat* chorusFeedbackPercent = nullptr;
     juce::AudioParameterFloat* chorusMixPercent = nullptr;
+    juce::AudioParameterInt*   chorusVoices = nullptr;
+    juce::AudioParameterFloat* chorusSpreadPercent = nullptr;
     juce::AudioParameterBool*  chorusBypass = nullptr;
     //  OD
     juce::AudioParameterFloat* overdriveSaturation = nullptr;
+    juce::AudioParameterChoice* overdriveCurve = nullptr;
+    juce::AudioParameterFloat* overdrivePreToneHz = nullptr;
+    juce::AudioParameterFloat* overdrivePostToneHz = nullptr;
+    juce::AudioParameterChoice* overdriveOversampling = nullptr;
     juce::AudioParameterBool*  overdriveBypass = nullptr;
     //   LADDER FILTER
     juce::AudioParameterChoice* ladderFilterMode = nullptr;
     juce::AudioParameterFloat*  ladderFilterCutoffHz = nullptr;
     juce::AudioParameterFloat*  ladderFilterResonance = nullptr;
     juce::AudioParameterFloat*  ladderFilterDrive = nullptr;
+    juce::AudioParameterChoice* ladderFilterOversampling = nullptr;
+    juce::AudioParameterFloat*  ladderFilterDynamicPercent = nullptr;
     juce::AudioParameterBool*   ladderFilterBypass = nullptr;
     //    GENERAL FILTER
     juce::AudioParameterChoice* generalFilterMode = nullptr;
     juce::AudioParameterFloat*  generalFilterFreqHz = nullptr;
     juce::AudioParameterFloat*  generalFilterQuality = nullptr;
     juce::AudioParameterFloat*  generalFilterGain = nullptr;
+    juce::AudioParameterInt*    generalFilterStages = nullptr;
+    juce::AudioParameterFloat*  generalFilterDynamicPercent = nullptr;
     juce::AudioParameterBool*   generalFilterBypass = nullptr;
+    //    DELAY
+    juce::AudioParameterFloat*  delayTimeMs = nullptr;
+    juce::AudioParameterChoice* delaySync = nullptr;
+    juce::AudioParameterFloat*  delayFeedbackPercent = nullptr;
+    juce::AudioParameterChoice* delayMode = nullptr;
+    juce::AudioParameterFloat*  delayLowCutHz = nullptr;
+    juce::AudioParameterFloat*  delayHighCutHz = nullptr;
+    juce::AudioParameterFloat*  delayMixPercent = nullptr;
+    juce::AudioParameterBool*   delayBypass = nullptr;
     
     juce::AudioParameterInt* selectedTab = nullptr;
     
@@ -119,6 +233,21 @@ class Project13AudioProcessor  : public juce::AudioProcessor
     juce::AudioParameterFloat* inputGain = nullptr;
     juce::AudioParameterFloat* outputGain = nullptr;
     
+    //    Dry/wet of the whole chain
+    juce::AudioParameterFloat* globalMixPercent = nullptr;
+    
+    //    MODULATION
+    std::array<juce::AudioParameterFloat*, ModulationSources::NumLFOs> lfoRateHz {};
+    std::array<juce::AudioParameterChoice*, ModulationSources::NumLFOs> lfoShape {};
+    juce::AudioParameterFloat* envelopeAttackMs = nullptr;
+    juce::AudioParameterFloat* envelopeReleaseMs = nullptr;
+    juce::AudioParameterFloat* sequencerRateHz = nullptr;
+    std::array<juce::AudioParameterFloat*, ModulationSources::NumSteps> sequencerStepPercent {};
+    //    each slot routes one source to one smoothed param
+    static constexpr size_t NumModulationSlots = 8;
+    std::array<juce::AudioParameterChoice*, NumModulationSlots> modulationSource {}, modulationDestination {};
+    std::array<juce::AudioParameterFloat*, NumModulationSlots> modulationDepthPercent {};
+    
     //    SMOOTHED
     //  Phase
     juce::SmoothedValue<float>
@@ -132,18 +261,92 @@ class Project13AudioProcessor  : public juce::AudioProcessor
     chorusCenterDelaymsSmoother,
     chorusFeedbackPercentSmoother,
     chorusMixPercentSmoother,
+    chorusSpreadPercentSmoother,
     overdriveSaturationSmoother,
+    overdrivePreToneHzSmoother,
+    overdrivePostToneHzSmoother,
     ladderFilterCutoffHzSmoother,
     ladderFilterResonanceSmoother,
     ladderFilterDriveSmoother,
     generalFilterFreqHzSmoother,
     generalFilterQualitySmoother,
     generalFilterGainSmoother,
+    delayFeedbackPercentSmoother,
+    delayLowCutHzSmoother,
+    delayHighCutHzSmoother,
+    delayMixPercentSmoother,
     inputGainSmoother,
-    outputGainSmoother;
+    outputGainSmoother,
+    globalMixPercentSmoother;
+    
+    //    RAMPS
+    //  per-sample values of the smoothers above for the current block. The gain ramps hold linear gain, not dB.
+    ParameterRamp
+    phaserRatehzRamp,
+    phaserCenterFreqhzRamp,
+    phaserDepthPercentRamp,
+    phaserFeedbackPercentRamp,
+    phaserMixPercentRamp,
+    chorusRatehzRamp,
+    chorusDepthPercentRamp,
+    chorusCenterDelaymsRamp,
+    chorusFeedbackPercentRamp,
+    chorusMixPercentRamp,
+    chorusSpreadPercentRamp,
+    overdriveSaturationRamp,
+    overdrivePreToneHzRamp,
+    overdrivePostToneHzRamp,
+    ladderFilterCutoffHzRamp,
+    ladderFilterResonanceRamp,
+    ladderFilterDriveRamp,
+    generalFilterFreqHzRamp,
+    generalFilterQualityRamp,
+    generalFilterGainRamp,
+    delayFeedbackPercentRamp,
+    delayLowCutHzRamp,
+    delayHighCutHzRamp,
+    delayMixPercentRamp,
+    inputGainRamp,
+    outputGainRamp,
+    globalMixPercentRamp;
+    
+    //number of samples the chain processes between control-rate updates (LFO rates, cutoffs, coefficients).
+    //Smaller is smoother automation, larger is cheaper. Saved with the session.
+    static constexpr int DefaultSubBlockSize = 64;
+    void setSubBlockSize(int newSize);
+    int getSubBlockSize() const { return subBlockSize.load(); }
+    
+    //the chain's latency as of the last block. getLatencySamples() only catches up once the message
+    //thread has run, which never happens during a headless render.
+    int getProcessingLatencySamples() const { return latencyToReport.load(); }
+    
+    //offline renders spread the work over a pool of threads unless this is turned off, e.g. by a
+    //caller that already runs one processor per core. Takes effect at the next prepareToPlay().
+    void setUseWorkerThreads(bool shouldUseWorkers) { useWorkerThreads = shouldUseWorkers; }
+    
+    //largest bus accepted by isBusesLayoutSupported(), i.e. 7.1.4
+    static constexpr int MaxChannels = 12;
+    
+    //one block's meter readings, indexed by channel of the main bus. The input is measured by the
+    //envelope follower's pass, so it only has RMS and peak. The output has true peak and loudness too.
+    struct MeterFrame
+    {
+        struct InputLevels
+        {
+            float rms = 0.f, peak = 0.f;
+        };
+        
+        std::array<InputLevels, MaxChannels> input {};
+        OutputMeter<MaxChannels>::Readings output {};
+        int numChannels = 0;
+        float seconds = 0.f; //how much audio the frame covers
+        
+        //folds a later frame into this one: RMS by power over the time covered, the louder peaks, the newer loudness
+        void merge(const MeterFrame& next);
+    };
     
-    juce::Atomic<bool> guiNeedsLatestDspOrder {false};
-    juce::Atomic<float> leftPreRMS, rightPreRMS, leftPostRMS, rightPostRMS;
+    //the editor's timer drains every block's frame, so meters see the transients between its repaints
+    bool pullMeterFrame(MeterFrame& frame) { return meterHistory.pop(frame); }
     
     SimpleMBComp::SingleChannelSampleFifo<juce::AudioBuffer<float>> leftSCSF {SimpleMBComp::Channel::Left}, rightSCSF {SimpleMBComp::Channel::Right};
         
@@ -152,8 +355,128 @@ class Project13AudioProcessor  : public juce::AudioProcessor
 private:
     
     DSP_Order dspOrder;
+    DSP_Routing dspRouting;
+    
+    static constexpr size_t CommandQueueSize = 64;
+    LockFreeQueue<DSP_Command, CommandQueueSize> commands;
+    LockFreeQueue<DSP_Event, CommandQueueSize> events;
+    std::atomic<juce::uint32> nextCommandId {1};
+    
+    //sendCommand() without noting the graph, for commands whose graph was noted when they were first sent
+    juce::uint32 pushCommand(DSP_Command command);
+    
+    //the graph as every Reorder and PresetSwap sent so far leaves it, including those still queued.
+    //getStateInformation() saves it, as the audio thread's dspOrder and dspRouting can't be read elsewhere.
+    void noteRequestedGraph(const DSP_Command& command);
+    DSP_Graph getRequestedGraph() const;
+    juce::CriticalSection requestedGraphLock;
+    DSP_Graph requestedGraph;
+    
+    //message thread only. Commands that found the queue full, oldest first, retried by timerCallback().
+    std::vector<DSP_Command> unsentCommands;
+    void queueCommand(const DSP_Command& command);
+    void timerCallback() override;
+    
+    //reset() and setStateInformation() may be called on any thread. Off the message thread, a command
+    //that finds the queue full is handed over here and sent from handleAsyncUpdate().
+    void sendCommandFromAnyThread(const DSP_Command& command);
+    juce::CriticalSection handOverLock;
+    std::vector<DSP_Command> handedOverCommands;
+    
+    //audio thread only. Commands are moved here from the queue and applied once their sample comes up.
+    std::array<DSP_Command, CommandQueueSize> pendingCommands;
+    size_t numPendingCommands = 0;
+    juce::int64 samplePosition = 0;
+    std::atomic<juce::int64> publishedSamplePosition {0};
+    
+    //where the sub-block grid and the modulation ticks start counting from. Moved up to samplePosition by
+    //prepareToPlay() and the Reset command, so a render lines up the same way whatever ran before it.
+    juce::int64 gridStart = 0;
+    
+    //applies the pending commands that are due by the start of a block of numSamples. Returns where
+    //in the block the next one is due, or numSamples if none is.
+    int applyDueCommands(int numSamples);
+    void applyCommand(const DSP_Command& command);
+    
+    //a smoothed param's new value and the sample it takes effect on. Queued by parameterValueChanged()
+    //from whichever thread changed the param, and turned into the smoother's target when it is due.
+    struct ParameterEvent
+    {
+        juce::int64 samplePosition = 0;
+        int binding = 0; //index into smootherBindings
+        float value = 0.f;
+    };
+    
+    static constexpr size_t ParameterEventQueueSize = 512;
+    LockFreeQueue<ParameterEvent, ParameterEventQueueSize> parameterEvents;
+    std::atomic<bool> parameterEventsLost {false};
+    
+    //audio thread only, like pendingCommands
+    std::array<ParameterEvent, ParameterEventQueueSize> pendingParameterEvents;
+    size_t numPendingParameterEvents = 0;
+    
+    //indexed by getParameterIndex(). -1 for params without a smoother.
+    std::vector<int> bindingForParameter;
+    
+    //set by setParameterAt() around its setValueNotifyingHost(), which calls parameterValueChanged() on the same thread
+    static thread_local juce::int64 parameterChangePosition;
+    
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int, bool) override {}
+    
+    //the same as applyDueCommands(), for parameter events
+    int applyDueParameterEvents(int numSamples);
+    
+    //everything processBlock() does for one segment of the host block, with no command or parameter
+    //change due inside it. Moves samplePosition on past it.
+    void processSegment(juce::AudioBuffer<float>& buffer);
+    
+    //indexed by DSP_Option. The bypass params, overridden by Bypass commands until the param next changes.
+    using StageBypasses = std::array<bool, NumDSPOptions>;
+    StageBypasses stageBypasses {}, lastParamBypasses {};
+    StageBypasses getBypassParams() const;
+    void updateStageBypasses();
+    
+    std::atomic<int> subBlockSize {DefaultSubBlockSize};
+    
+    //1, 2, 3 ... shared by every ParameterRamp
+    juce::HeapBlock<float> rampIndices;
+    int maxRampLength = 0;
     
-    juce::dsp::Gain<float> inputGainDSP, outputGainDSP;
+    void applyGainRamp(juce::AudioBuffer<float>& buffer, const ParameterRamp& gainRamp);
+    
+    //latency changes found on the audio thread are handed to setLatencySamples() on the message thread
+    std::atomic<int> latencyToReport {0};
+    void handleAsyncUpdate() override;
+    
+    //read from the play head every block for tempo-synced delay times. Also read by getTailLengthSeconds().
+    std::atomic<double> hostBpm {120.0};
+    
+    //the tail adds up the decay of every active feedback loop and resonance, capped at MaxTailSeconds.
+    //Feedback at or near 100% would otherwise never end.
+    static constexpr double TailDecayDb = 80.0;
+    static constexpr double MaxTailSeconds = 30.0;
+    static constexpr double MaxTailFeedback = 0.999;
+    double computeTailSeconds() const;
+    
+    //skips the chain once silent input has outlasted the tail
+    SleepState sleepState;
+    
+    //one pass over the input (by the envelope follower) and one over the output, shared by the meters and sleepState
+    LevelDetector inputLevels;
+    OutputMeter<MaxChannels> outputMeter;
+    MeterFrame meters;
+    
+    //one frame per block. 512 is about a third of a second of 32 sample blocks at 48 kHz.
+    static constexpr size_t MeterHistorySize = 512;
+    SPSCRing<MeterFrame, MeterHistorySize> meterHistory;
+    
+    //while the ring is full (no editor open, or it stalled) frames are merged here, so no peak goes missing
+    MeterFrame unsentMeterFrame;
+    bool hasUnsentMeterFrame = false;
+    void pushMeterFrame(const MeterFrame& frame);
+    
+    void pushToAnalyzer(juce::AudioBuffer<float>& buffer);
     
     template <typename DSP>
     struct DSP_Choice : juce::dsp::ProcessorBase
@@ -174,40 +497,195 @@ private:
         DSP dsp;
     };
     
-    struct MonoChannelDSP
+    //one chain for a group of up to SIMDLanes::NumLanes channels of the bus. Each processor keeps
+    //per-channel state but computes its coefficients and LFOs once per update, shared by the group.
+    struct ChannelChainDSP
     {
-        MonoChannelDSP (Project13AudioProcessor& proc) : p(proc) {}
+        ChannelChainDSP (Project13AudioProcessor& proc) : p(proc) {}
+        
+        DSP_Choice<RampedLadderFilter> ladderFilter;
+        
+        //ring buffers are sized in prepare() for DelayEngine::MaxDelaySeconds
+        DelayEngine delay;
+        
+        //every stage has its own lanes and dry buffer so stages on parallel branches share no scratch memory
+        PhaserEngine phaser;
+        ChorusEngine chorus;
+        SIMDLanes phaserLanes, chorusLanes;
+        
+        //runs on interleaved lanes like the general filter, sized for the highest oversampling factor
+        WaveshaperOverdrive overdrive;
+        SIMDLanes overdriveLanes;
+        
+        //the general filter runs every channel as a lane of one SIMD register.
+        static constexpr size_t MaxGeneralFilterStages = 4;
+        BiquadCascade<SIMDLanes::Register, MaxGeneralFilterStages> generalFilter;
+        SIMDLanes generalFilterLanes;
         
-        DSP_Choice<juce::dsp::DelayLine<float>> delay;
-        DSP_Choice<juce::dsp::Phaser<float>> phaser;
-        DSP_Choice<juce::dsp::Chorus<float>> chorus;
-        DSP_Choice<juce::dsp::LadderFilter<float>> overdrive, ladderFilter;
-        DSP_Choice<juce::dsp::IIR::Filter<float>> generalFilter;
+        //the nonlinear stages can run oversampled, each at its own factor
+        StageOversampler overdriveOversampler, ladderFilterOversampler;
         
         void prepare(juce::dsp::ProcessSpec& spec);
         
-        void updateDSPFromParams();
+        //the side of each of the group's channels, for the chorus spread, ping-pong and leaving the LFE alone
+        void setChannelSides(const LaneSides& sides);
         
-        void process(juce::dsp::AudioBlock<float> block, const DSP_Order& dspOrder);
+        //latency of the oversampling filters along the routing, at the host rate.
+        //Parallel sections add the latency of their slowest branch.
+        int getLatencyInSamples() const;
+        
+        //control-rate parameters are read from the ramps at rampOffset, the sub-block's start within the host block.
+        void updateDSPFromParams(size_t rampOffset);
+        
+        //swaps in the process function generated for this order. Call when a Reorder or PresetSwap command is applied.
+        void setOrder(const DSP_Order& newOrder);
+        
+        //rebuilds the routing plan. Call when a PresetSwap command is applied.
+        void setRouting(const DSP_Routing& newRouting);
+        
+        //clears every stage, the bypass fades and the compensation delays. Allocates nothing.
+        void reset();
+        
+        //after sleeping: takes the current parameters and resets, so nothing glides from where it was before.
+        //Only the tail is lost, and it had already died away below the sleep threshold.
+        void wake();
+        
+        void process(juce::dsp::AudioBlock<float> block, size_t rampOffset);
+        
+        //a whole host block starting blockStart samples after gridStart: process() for every sub-block,
+        //and updateDSPFromParams() for every one starting on a multiple of subBlockSize
+        void processInSubBlocks(juce::dsp::AudioBlock<float> block, juce::int64 blockStart, size_t subBlockSize);
+        
+        //offline rendering only works section by section, so it needs a routing with parallel branches
+        //and an order that is a permutation of DSP_Option (every stage appears in exactly one lane).
+        bool canUseWorkers() const;
+        
+        //processes a whole host block, running the branches of each parallel section as tasks on workers.
+        //Every stage picks up its oversampling, bypass and params on the same sub-blocks as with
+        //updateDSPFromParams() and process(), and the branches are summed in a fixed order, so the
+        //output is identical. The latency compensation is set after the branches, on each side of the block's
+        //first update point, which is the only place an oversampling change can move it.
+        void processWithWorkers(juce::dsp::AudioBlock<float> block, juce::int64 blockStart, size_t subBlockSize, WorkStealingPool& workers);
         
     private:
         Project13AudioProcessor& p;
+        juce::dsp::ProcessSpec preparedSpec;
+        
+        //swaps oversamplers when their choice params change and re-prepares the stage at the new rate.
+        //The option version only touches that stage, so branches can call it concurrently.
+        void updateOversampling();
+        void updateOversampling(DSP_Option option);
+        
+        //sub-blocks end on multiples of subBlockSize along the sample timeline, not counted from the host
+        //block's start, so control-rate updates land on the same samples whatever size the host's blocks are.
+        static size_t getSubBlockLength(juce::int64 position, size_t subBlockSize, size_t samplesRemaining);
+        bool isUpdatePoint(juce::int64 position, size_t subBlockSize) const;
+        
+        //set by prepare() and reset(), so the first sub-block is updated wherever it starts
+        bool needsUpdate = true;
+        
+        //fully bypassed stages aren't updated. processStage() catches them up when they come back.
+        template <DSP_Option Option>
+        void updateStage(size_t rampOffset);
+        
+        //clears a stage's state so it comes back from bypass without replaying what it held before
+        template <DSP_Option Option>
+        void resetStage();
+        
+        using UpdateFn = void (ChannelChainDSP::*)(size_t);
+        static const std::array<UpdateFn, NumDSPOptions>& getUpdateTable();
+        
         GeneralFilterMode filterMode = GeneralFilterMode::END_OF_LIST;
         float filterFreq = 0.f, filterQ = 0.f, filterGain = -100.f; //different values than default to update them when plugin is opened
+        int filterStages = 0;
+        
+        //phaser, chorus and delay are fully wet; their mix is applied per sample from the mix ramps.
+        DryWetBuffer phaserMix, chorusMix, delayMix;
+        
+        //indexed by DSP_Option. Stages with latency (the oversampled ones) delay their input by it while
+        //bypassed and line their dry signal up with it while fading, so toggling them doesn't move the latency.
+        std::array<BypassFader, NumDSPOptions> bypassFaders;
+        std::array<CompensationDelay, NumDSPOptions> bypassDelays;
+        
+        //global dry/wet. The dry copy is delayed by the chain's latency to stay in phase with the wet signal.
+        DryWetBuffer chainMix;
+        CompensationDelay chainDryDelay;
+        
+        using Context = juce::dsp::ProcessContextReplacing<float>;
+        using ProcessFn = void (*)(ChannelChainDSP&, Context&, const StageBypasses&, size_t rampOffset);
+        
+        static constexpr size_t NumPermutations = ChainPermutations::factorial(NumDSPOptions);
+        
+        template <DSP_Option Option>
+        void processStage(Context& context, bool bypassed, size_t rampOffset);
+        
+        template <size_t PermutationIndex>
+        static void processPermutation(ChannelChainDSP& chain, Context& context, const StageBypasses& bypassed, size_t rampOffset);
+        
+        //fallback for orders that aren't a permutation of DSP_Option (duplicates, END_OF_LIST).
+        static void processArbitraryOrder(ChannelChainDSP& chain, Context& context, const StageBypasses& bypassed, size_t rampOffset);
+        
+        static const std::array<ProcessFn, NumPermutations>& getPermutationTable();
+        
+        using StageFn = void (ChannelChainDSP::*)(Context&, bool, size_t);
+        static const std::array<StageFn, NumDSPOptions>& getStageTable();
+        
+        StageBypasses getBypasses() const;
+        
+        void processLane(const DSP_Routing::Lane& lane, Context& context, const StageBypasses& bypassed, size_t rampOffset);
+        
+        //every section of the plan over a piece of the host block starting rampOffset into it. The stages' latency
+        //can't change in it after its first sub-block.
+        void processSectionsWithWorkers(juce::dsp::AudioBlock<float> block, juce::int64 blockStart, size_t rampOffset, size_t subBlockSize, WorkStealingPool& workers);
+        
+        //offline version of processLane() for a whole host block: updates the lane's stages before each sub-block
+        void processLaneInSubBlocks(const DSP_Routing::Lane& lane, juce::dsp::AudioBlock<float> block, juce::int64 blockStart, size_t rampOffset, size_t subBlockSize);
+        
+        //serial sections run in place. Parallel sections run each branch in its own buffer and sum them.
+        void processGraph(juce::dsp::AudioBlock<float> block, const StageBypasses& bypassed, size_t rampOffset);
+        
+        //a branch of a parallel section runs on a copy of the section's input made by beginBranch(). endBranch() delays
+        //it to the section's latency and scales it by the branch mix. Touches nothing another branch of the section touches.
+        juce::dsp::AudioBlock<float> beginBranch(size_t laneIndex, const juce::dsp::AudioBlock<float>& input);
+        void endBranch(const DSP_Routing::Section& section, size_t laneIndex, const juce::dsp::AudioBlock<float>& branchBlock);
+        void sumBranches(const DSP_Routing::Section& section, juce::dsp::AudioBlock<float>& block);
+        juce::dsp::AudioBlock<float> getBranchBlock(size_t laneIndex, const juce::dsp::AudioBlock<float>& input);
+        
+        //global dry/wet, after the whole graph
+        void applyChainMix(const juce::dsp::AudioBlock<float>& block, size_t rampOffset);
+        
+        int getStageLatency(DSP_Option option) const;
+        int getLaneLatency(const DSP_Routing::Lane& lane) const;
+        int getSectionLatency(const DSP_Routing::Section& section) const;
+        
+        DSP_Order order;
+        DSP_Routing routing;
+        DSP_Routing::Plan plan;
+        ProcessFn processFn = nullptr;
+        
+        //indexed by lane within a section, which is reused by every parallel section
+        std::array<juce::AudioBuffer<float>, DSP_Routing::MaxBranches> branchBuffers;
+        //indexed by the branch's first stage, so no two branches of the graph share one
+        std::array<CompensationDelay, NumDSPOptions> branchDelays;
+        
+        void rebuildPlan();
     };
     
-    MonoChannelDSP leftChannel {*this};
-    MonoChannelDSP rightChannel {*this};
+    //one chain per SIMDLanes::NumLanes channels of the bus, created in prepareToPlay() for the current layout.
+    //Every chain gets the same order and routing, so any of them can report the latency.
+    std::vector<std::unique_ptr<ChannelChainDSP>> channelChains;
     
+    //the channels of block processed by channelChains[group]. The block must reach into the group.
+    static juce::dsp::AudioBlock<float> getChannelGroupBlock(const juce::dsp::AudioBlock<float>& block, size_t group);
     
+    //only exists while the host renders offline. See prepareToPlay().
+    std::unique_ptr<WorkStealingPool> workers;
+    bool useWorkerThreads = true;
+    
+    //the analyzer always takes two channels. Mono is copied to both.
+    juce::AudioBuffer<float> analyzerBuffer;
     
-    struct ProcessState
-    {
-        juce::dsp::ProcessorBase* processor = nullptr;
-        bool bypassed = false;
-    };
     
-    using DSP_Pointers = std::array<ProcessState, static_cast<size_t>(DSP_Option::END_OF_LIST)>;
     
 #define VERIFY_BYPASS_FUNCTIONALITY false
     
@@ -223,7 +701,39 @@ private:
     }
     
     
-    std::vector<juce::SmoothedValue<float>*> getSmoothers();
+    //each smoothed float param paired with its smoother. Built once in the constructor so
+    //updateSmootherFromParams() never has to build a container on the audio thread.
+    struct SmootherBinding
+    {
+        juce::AudioParameterFloat* param = nullptr;
+        juce::SmoothedValue<float>* smoother = nullptr;
+        ParameterRamp* ramp = nullptr;
+        bool rampHoldsGain = false;
+    };
+    
+    static constexpr size_t NumSmoothedParams = 27;
+    std::array<SmootherBinding, NumSmoothedParams> smootherBindings;
+    
+    void initSmootherBindings();
+    
+    //the sources tick once per sub-block. The matrix adds their ramps to the smoothed params' ramps,
+    //in each param's normalised range, before per-sample and control-rate consumers read them.
+    ModulationSources modulationSources;
+    
+    //the filters' dynamic amounts, each an envelope route to its cutoff's smoother binding, added after the slots
+    static constexpr size_t NumDynamicFilterRoutes = 2;
+    std::array<std::pair<juce::AudioParameterFloat*, size_t>, NumDynamicFilterRoutes> dynamicFilterRoutes {};
+    
+    ModulationMatrix<NumModulationSlots + NumDynamicFilterRoutes, NumSmoothedParams> modulationMatrix;
+    
+    //index into smootherBindings for each choice of the slots' destination params
+    std::array<size_t, NumSmoothedParams> modulationDestinationBindings {};
+    
+    ModulationSources::Settings getModulationSettings() const;
+    
+    //runs the sources over the block's input, measuring inputLevels as it goes, and rebuilds the routes from
+    //the slots and the filters' dynamic amounts
+    void updateModulation(const juce::AudioBuffer<float>& input, juce::int64 blockStart);
     
     enum class SmootherUpdateMode
     {
@@ -231,7 +741,8 @@ private:
         liveInRealTime
     };
     
-    void updateSmootherFromParams(int numSamplesToSkip, SmootherUpdateMode init);
+    //advances every smoother by numSamples and fills its ramp with the values it passed through.
+    void updateSmootherFromParams(int numSamples, SmootherUpdateMode init);
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Project13AudioProcessor)
 };
@@ -0,0 +1,583 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 18 Oct 2026 3:24:08pm
+    Author:  Aaron Petrini
+
+    Headless processBlock benchmark.
+    Runs Project13AudioProcessor over synthetic signals for a matrix of configurations
+    and prints one JSON object per configuration (JSON lines) to stdout.
+
+    Usage: Project13Benchmark [--seconds <s>] [--sweep <name>] [--full] [--check]
+      --sweep  one of rates, orders, bypass, automation, signals, channels, modulation, subblock, routing
+               (default: all of them)
+               The "decay" signal is noise through the warmup, then silence with every
+               feedback path near its maximum, timing the tails as they decay toward denormals.
+      --full   the whole cartesian product of rates x orders x bypass x automation. Slow.
+      --check  instead of timing, renders pairs of configurations that must produce the same samples
+               and compares them: graphs of single-branch sections against the serial chain, and
+               offline renders on the worker threads against realtime ones, also with the oversampling
+               changing mid-block. Exits with 1 if any pair differs.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include <iostream>
+
+namespace
+{
+using Option = Project13AudioProcessor::DSP_Option;
+using Order = Project13AudioProcessor::DSP_Order;
+using Routing = Project13AudioProcessor::DSP_Routing;
+using Branches = std::array<int, Project13AudioProcessor::NumDSPOptions>;
+constexpr auto NumOptions = Project13AudioProcessor::NumDSPOptions;
+
+enum class Signal { Noise, Sine, Silence, Decay };
+enum class Automation { None, Sparse, Dense };
+
+struct Config
+{
+    juce::String sweep;
+    double sampleRate = 48000.0;
+    int blockSize = 64;
+    int numChannels = 2;
+    Order order = ChainPermutations::all<Option, NumOptions>[0];
+    Routing routing; //serial
+    int bypassMask = 0; //bit n bypasses DSP_Option n
+    Automation automation = Automation::None;
+    Signal signal = Signal::Noise;
+    int numModulationRoutes = 0;
+    int subBlockSize = Project13AudioProcessor::DefaultSubBlockSize;
+    bool offline = false; //renders as the host would offline, on the processor's worker threads
+    bool switchOversampling = false; //steps the overdrive and ladder filter oversampling every few blocks
+};
+
+struct Result
+{
+    int numBlocks = 0;
+    double nsPerSample = 0.0, worstBlockNs = 0.0, p50BlockNs = 0.0, p95BlockNs = 0.0, p99BlockNs = 0.0;
+};
+
+juce::String getOptionName(Option option)
+{
+    switch (option)
+    {
+        case Option::Phase:         return "phase";
+        case Option::Chorus:        return "chorus";
+        case Option::Overdrive:     return "overdrive";
+        case Option::LadderFilter:  return "ladder";
+        case Option::GeneralFilter: return "filter";
+        case Option::Delay:         return "delay";
+        case Option::END_OF_LIST:   break;
+    }
+    return "none";
+}
+
+juce::String getOrderName(const Order& order)
+{
+    juce::StringArray names;
+    for (auto option : order)
+        names.add(getOptionName(option));
+    return names.joinIntoString(">");
+}
+
+//one digit per DSP_Option, its branch
+juce::String getRoutingName(const Routing& routing)
+{
+    juce::String name;
+    for (auto branch : routing.branches)
+        name << branch;
+    return name;
+}
+
+Routing makeRouting(const Branches& branches)
+{
+    Routing routing;
+    routing.branches = branches;
+    return routing;
+}
+
+juce::String getAutomationName(Automation a)
+{
+    return a == Automation::None ? "none" : a == Automation::Sparse ? "sparse" : "dense";
+}
+
+juce::String getSignalName(Signal s)
+{
+    switch (s)
+    {
+        case Signal::Noise:   return "noise";
+        case Signal::Sine:    return "sine";
+        case Signal::Silence: return "silence";
+        case Signal::Decay:   return "decay";
+    }
+    return "none";
+}
+
+std::vector<juce::AudioParameterBool*> getBypassParams(Project13AudioProcessor& p)
+{
+    //indexed by DSP_Option
+    return { p.phaserBypass, p.chorusBypass, p.overdriveBypass, p.ladderFilterBypass, p.generalFilterBypass, p.delayBypass };
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    auto index = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size()))) - 1;
+    return sorted[juce::jlimit<size_t>(0, sorted.size() - 1, index)];
+}
+
+//sets a processor up for a config, then feeds it the config's signal and automation block by block.
+//Two drivers for the same config feed their processors exactly the same blocks.
+struct Driver
+{
+    Driver(Project13AudioProcessor& p, const Config& c) : processor(p), config(c)
+    {
+        auto bypassParams = getBypassParams(processor);
+        jassert(bypassParams.size() == NumOptions);
+        for (size_t i = 0; i < bypassParams.size(); ++i)
+            bypassParams[i]->setValueNotifyingHost((config.bypassMask >> i) & 1 ? 1.f : 0.f);
+
+        //each route takes the next source and a different destination
+        for (int slot = 0; slot < config.numModulationRoutes; ++slot)
+        {
+            auto index = static_cast<size_t>(slot);
+            auto* source = processor.modulationSource[index];
+            auto* destination = processor.modulationDestination[index];
+            source->setValueNotifyingHost(source->convertTo0to1(static_cast<float>(1 + slot % ModulationSources::NumSources)));
+            destination->setValueNotifyingHost(destination->convertTo0to1(static_cast<float>(slot * 3 % destination->choices.size())));
+            processor.modulationDepthPercent[index]->setValueNotifyingHost(0.75f);
+        }
+
+        if (config.signal == Signal::Decay)
+        {
+            for (auto* param : { processor.phaserFeedbackPercent, processor.chorusFeedbackPercent,
+                                 processor.ladderFilterResonance, processor.delayFeedbackPercent })
+                param->setValueNotifyingHost(param->convertTo0to1(0.95f * param->range.end));
+        }
+
+        for (auto* param : processor.getParameters())
+            if (auto* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param))
+                automatable.push_back(floatParam);
+
+        processor.setSubBlockSize(config.subBlockSize);
+        processor.setNonRealtime(config.offline);
+        processor.sendCommand(Project13AudioProcessor::DSP_Command::presetSwap({config.order, config.routing}));
+        processor.setPlayConfigDetails(config.numChannels, config.numChannels, config.sampleRate, config.blockSize);
+        processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+        buffer.setSize(config.numChannels, config.blockSize);
+    }
+
+    //the next block of the signal, with this block's automation already sent. The decay signal is noise while warming up.
+    juce::AudioBuffer<float>& nextBlock(bool warmingUp)
+    {
+        for (int i = 0; i < config.blockSize; ++i)
+        {
+            float sample = 0.f;
+            if (config.signal == Signal::Noise || (config.signal == Signal::Decay && warmingUp))
+                sample = random.nextFloat() - 0.5f;
+            else if (config.signal == Signal::Sine)
+                sample = 0.5f * static_cast<float>(std::sin(phase));
+
+            phase = std::fmod(phase + phaseIncrement, juce::MathConstants<double>::twoPi);
+            for (int ch = 0; ch < config.numChannels; ++ch)
+                buffer.setSample(ch, i, sample);
+        }
+
+        //dense automation lands anywhere in the block, so the processor splits it at every change
+        if (config.automation == Automation::Dense)
+        {
+            const auto blockStart = processor.getSamplePosition();
+            for (auto* param : automatable)
+                processor.setParameterAt(*param, random.nextFloat(), blockStart + random.nextInt(config.blockSize));
+        }
+        else if (config.automation == Automation::Sparse && blockIndex % 8 == 0 && automatable.empty() == false)
+        {
+            automatable[nextAutomated]->setValueNotifyingHost(random.nextFloat());
+            nextAutomated = (nextAutomated + 1) % automatable.size();
+        }
+
+        //picked up on the next update point, which is inside the block when it doesn't start on the sub-block grid
+        if (config.switchOversampling && blockIndex % 5 == 0)
+        {
+            for (auto* param : { processor.overdriveOversampling, processor.ladderFilterOversampling })
+                param->setValueNotifyingHost(param->convertTo0to1(static_cast<float>((param->getIndex() + 1) % param->choices.size())));
+        }
+
+        ++blockIndex;
+        return buffer;
+    }
+
+    Project13AudioProcessor& processor;
+    const Config& config;
+    std::vector<juce::AudioParameterFloat*> automatable;
+    juce::AudioBuffer<float> buffer;
+    juce::Random random {0x5eed}; //fixed seed so runs are comparable
+    double phase = 0.0;
+    const double phaseIncrement = juce::MathConstants<double>::twoPi * 440.0 / config.sampleRate;
+    size_t nextAutomated = 0;
+    int blockIndex = 0;
+};
+
+Result run(const Config& config, double seconds)
+{
+    Project13AudioProcessor processor;
+    Driver driver(processor, config);
+    juce::MidiBuffer midi;
+
+    const auto warmupBlocks = static_cast<int>(0.25 * config.sampleRate / config.blockSize);
+    const auto numBlocks = juce::jmax(1, static_cast<int>(seconds * config.sampleRate / config.blockSize));
+
+    std::vector<double> blockTimes;
+    blockTimes.reserve(static_cast<size_t>(numBlocks));
+    double totalNs = 0.0;
+
+    for (int block = 0; block < warmupBlocks + numBlocks; ++block)
+    {
+        auto& buffer = driver.nextBlock(block < warmupBlocks);
+
+        auto start = std::chrono::steady_clock::now();
+        processor.processBlock(buffer, midi);
+        auto end = std::chrono::steady_clock::now();
+
+        if (block >= warmupBlocks)
+        {
+            auto ns = std::chrono::duration<double, std::nano>(end - start).count();
+            blockTimes.push_back(ns);
+            totalNs += ns;
+        }
+    }
+
+    processor.releaseResources();
+
+    std::sort(blockTimes.begin(), blockTimes.end());
+
+    Result result;
+    result.numBlocks = numBlocks;
+    result.nsPerSample = totalNs / (static_cast<double>(numBlocks) * config.blockSize);
+    result.worstBlockNs = blockTimes.back();
+    result.p50BlockNs = percentile(blockTimes, 0.50);
+    result.p95BlockNs = percentile(blockTimes, 0.95);
+    result.p99BlockNs = percentile(blockTimes, 0.99);
+    return result;
+}
+
+//the processor's output over numBlocks blocks, channel after channel of each block
+std::vector<float> render(const Config& config, int numBlocks)
+{
+    Project13AudioProcessor processor;
+    Driver driver(processor, config);
+    juce::MidiBuffer midi;
+
+    std::vector<float> output;
+    output.reserve(static_cast<size_t>(numBlocks * config.blockSize * config.numChannels));
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        auto& buffer = driver.nextBlock(false);
+        processor.processBlock(buffer, midi);
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            output.insert(output.end(), buffer.getReadPointer(ch), buffer.getReadPointer(ch) + buffer.getNumSamples());
+    }
+
+    processor.releaseResources();
+    return output;
+}
+
+void print(const Config& config, const Result& result)
+{
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty("sweep", config.sweep);
+    obj->setProperty("sampleRate", config.sampleRate);
+    obj->setProperty("blockSize", config.blockSize);
+    obj->setProperty("channels", config.numChannels);
+    obj->setProperty("order", getOrderName(config.order));
+    obj->setProperty("routing", getRoutingName(config.routing));
+    obj->setProperty("bypassMask", config.bypassMask);
+    obj->setProperty("automation", getAutomationName(config.automation));
+    obj->setProperty("signal", getSignalName(config.signal));
+    obj->setProperty("modulationRoutes", config.numModulationRoutes);
+    obj->setProperty("subBlockSize", config.subBlockSize);
+    obj->setProperty("offline", config.offline);
+    obj->setProperty("switchOversampling", config.switchOversampling);
+    obj->setProperty("blocks", result.numBlocks);
+    obj->setProperty("nsPerSample", result.nsPerSample);
+    obj->setProperty("worstBlockNs", result.worstBlockNs);
+    obj->setProperty("p50BlockNs", result.p50BlockNs);
+    obj->setProperty("p95BlockNs", result.p95BlockNs);
+    obj->setProperty("p99BlockNs", result.p99BlockNs);
+
+    std::cout << juce::JSON::toString(juce::var(obj.release()), true, 6) << std::endl;
+}
+
+const std::array<double, 3> sampleRates { 44100.0, 48000.0, 96000.0 };
+const std::array<int, 5> blockSizes { 32, 64, 256, 1024, 8192 };
+const std::array<Automation, 3> automations { Automation::None, Automation::Sparse, Automation::Dense };
+const std::array<Signal, 4> signals { Signal::Noise, Signal::Sine, Signal::Silence, Signal::Decay };
+const std::array<int, 5> channelCounts { 1, 2, 6, 8, 12 }; //mono, stereo, 5.1, 7.1, 7.1.4
+const std::array<int, 4> modulationRouteCounts { 0, 1, 4, 8 };
+const std::array<int, 7> subBlockSizes { 8, 16, 32, 64, 128, 256, 1024 };
+
+//branches indexed by DSP_Option, which in the default order is also the position in the chain
+const std::array<Branches, 5> routings
+{{
+    { 0, 0, 0, 0, 0, 0 }, //serial
+    { 1, 1, 1, 2, 2, 2 }, //two branches of three stages
+    { 1, 2, 3, 4, 5, 6 }, //every stage on its own branch
+    { 0, 1, 2, 0, 1, 2 }, //two sections of two branches, each after a serial stage
+    { 1, 2, 0, 0, 3, 3 }, //two branches, two serial stages, then a single branch
+}};
+
+//every parallel section holds a single branch, so each must render exactly what the serial chain does
+const std::array<Branches, 3> singleBranchRoutings
+{{
+    { 1, 1, 1, 1, 1, 1 },
+    { 0, 1, 1, 0, 2, 2 },
+    { 3, 0, 0, 0, 0, 3 },
+}};
+
+std::vector<Config> makeSweep(const juce::String& name)
+{
+    std::vector<Config> configs;
+    Config base;
+    base.sweep = name;
+
+    if (name == "rates")
+    {
+        for (auto sr : sampleRates)
+            for (auto bs : blockSizes)
+            {
+                auto c = base;
+                c.sampleRate = sr;
+                c.blockSize = bs;
+                configs.push_back(c);
+            }
+    }
+    else if (name == "orders")
+    {
+        for (const auto& order : ChainPermutations::all<Option, NumOptions>)
+        {
+            auto c = base;
+            c.order = order;
+            configs.push_back(c);
+        }
+    }
+    else if (name == "bypass")
+    {
+        for (int mask = 0; mask < (1 << NumOptions); ++mask)
+        {
+            auto c = base;
+            c.bypassMask = mask;
+            configs.push_back(c);
+        }
+    }
+    else if (name == "automation")
+    {
+        for (auto a : automations)
+        {
+            auto c = base;
+            c.automation = a;
+            configs.push_back(c);
+        }
+    }
+    else if (name == "signals")
+    {
+        for (auto s : signals)
+        {
+            auto c = base;
+            c.signal = s;
+            configs.push_back(c);
+        }
+    }
+    else if (name == "channels")
+    {
+        for (auto n : channelCounts)
+        {
+            auto c = base;
+            c.numChannels = n;
+            configs.push_back(c);
+        }
+    }
+    else if (name == "modulation")
+    {
+        for (auto n : modulationRouteCounts)
+        {
+            auto c = base;
+            c.numModulationRoutes = n;
+            configs.push_back(c);
+        }
+    }
+    else if (name == "subblock")
+    {
+        //with dense automation, so the cost of the control-rate updates shows
+        for (auto size : subBlockSizes)
+            for (auto a : { Automation::None, Automation::Dense })
+            {
+                auto c = base;
+                c.blockSize = 1024;
+                c.subBlockSize = size;
+                c.automation = a;
+                configs.push_back(c);
+            }
+    }
+    else if (name == "routing")
+    {
+        for (const auto& branches : routings)
+        {
+            auto c = base;
+            c.routing = makeRouting(branches);
+            configs.push_back(c);
+        }
+    }
+    else if (name == "full")
+    {
+        for (auto sr : sampleRates)
+            for (auto bs : blockSizes)
+                for (const auto& order : ChainPermutations::all<Option, NumOptions>)
+                    for (int mask = 0; mask < (1 << NumOptions); ++mask)
+                        for (auto a : automations)
+                        {
+                            auto c = base;
+                            c.sampleRate = sr;
+                            c.blockSize = bs;
+                            c.order = order;
+                            c.bypassMask = mask;
+                            c.automation = a;
+                            configs.push_back(c);
+                        }
+    }
+
+    return configs;
+}
+
+//two configurations that must render the same samples
+struct Check
+{
+    juce::String name;
+    Config expected, actual;
+};
+
+std::vector<Check> makeChecks()
+{
+    Config base;
+    base.sweep = "check";
+    base.automation = Automation::Sparse;
+
+    std::vector<Check> checks;
+    for (const auto& branches : singleBranchRoutings)
+    {
+        Check check { "singleBranch", base, base };
+        check.actual.routing = makeRouting(branches);
+        checks.push_back(check);
+    }
+
+    //the worker threads only change where the work runs. Parallel branches are tasks with one
+    //channel group, and with 7.1.4 every group is.
+    for (const auto& branches : routings)
+    {
+        for (auto numChannels : { 2, 12 })
+        {
+            Check check { "workers", base, base };
+            check.expected.routing = check.actual.routing = makeRouting(branches);
+            check.expected.numChannels = check.actual.numChannels = numChannels;
+            check.actual.offline = true;
+            checks.push_back(check);
+        }
+    }
+
+    //the same, with the latency moving mid-block: 96 sample blocks on a 64 sample grid start on it every other block
+    for (const auto& branches : routings)
+    {
+        for (auto numChannels : { 2, 12 })
+        {
+            Check check { "workersOversampling", base, base };
+            check.expected.routing = check.actual.routing = makeRouting(branches);
+            check.expected.numChannels = check.actual.numChannels = numChannels;
+            check.expected.blockSize = check.actual.blockSize = 96;
+            check.expected.subBlockSize = check.actual.subBlockSize = 64;
+            check.expected.switchOversampling = check.actual.switchOversampling = true;
+            check.actual.offline = true;
+            checks.push_back(check);
+        }
+    }
+
+    return checks;
+}
+
+//prints the check and returns true if every sample matched bit for bit
+bool runCheck(const Check& check, double seconds)
+{
+    const auto numBlocks = juce::jmax(1, static_cast<int>(seconds * check.expected.sampleRate / check.expected.blockSize));
+    const auto expected = render(check.expected, numBlocks);
+    const auto actual = render(check.actual, numBlocks);
+    jassert(expected.size() == actual.size());
+
+    float maxDifference = 0.f;
+    int numDifferent = 0;
+    for (size_t i = 0; i < juce::jmin(expected.size(), actual.size()); ++i)
+    {
+        if (expected[i] != actual[i])
+        {
+            maxDifference = juce::jmax(maxDifference, std::abs(expected[i] - actual[i]));
+            ++numDifferent;
+        }
+    }
+
+    const auto passed = numDifferent == 0 && expected.size() == actual.size();
+
+    auto obj = std::make_unique<juce::DynamicObject>();
+    obj->setProperty("check", check.name);
+    obj->setProperty("routing", getRoutingName(check.actual.routing));
+    obj->setProperty("channels", check.actual.numChannels);
+    obj->setProperty("samples", static_cast<int>(expected.size()));
+    obj->setProperty("differentSamples", numDifferent);
+    obj->setProperty("maxDifference", maxDifference);
+    obj->setProperty("passed", passed);
+
+    std::cout << juce::JSON::toString(juce::var(obj.release()), true, 6) << std::endl;
+    return passed;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit; //the APVTS needs a message manager
+
+    juce::ArgumentList args(argc, argv);
+    auto seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 2.0;
+
+    if (args.containsOption("--check"))
+    {
+        bool allPassed = true;
+        for (const auto& check : makeChecks())
+            allPassed = runCheck(check, seconds) && allPassed;
+        return allPassed ? 0 : 1;
+    }
+
+    juce::StringArray sweeps { "rates", "orders", "bypass", "automation", "signals", "channels", "modulation", "subblock", "routing" };
+    if (args.containsOption("--full"))
+        sweeps = { "full" };
+    else if (args.containsOption("--sweep"))
+        sweeps = { args.getValueForOption("--sweep") };
+
+    for (const auto& sweep : sweeps)
+    {
+        auto configs = makeSweep(sweep);
+        if (configs.empty())
+        {
+            std::cerr << "unknown sweep: " << sweep << std::endl;
+            return 1;
+        }
+
+        for (const auto& config : configs)
+            print(config, run(config, seconds));
+    }
+
+    return 0;
+}
@@ -0,0 +1,265 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 19 Oct 2026 9:12:44am
+    Author:  Aaron Petrini
+
+    Offline batch renderer.
+    Streams WAV/FLAC files through Project13AudioProcessor faster than realtime,
+    one processor per worker thread.
+
+    Usage: Project13Renderer --output <dir> [--state <file>] [--block <samples>] [--sub-block <samples>]
+                             [--jobs <n>] [--tail <seconds>] <input files...>
+      --state      a state blob as written by getStateInformation(). Defaults to the default parameters.
+      --block      block size passed to processBlock (default 8192)
+      --sub-block  samples between control-rate updates (default: the state's, or 64)
+      --jobs       number of worker threads (default: number of CPUs)
+      --tail       seconds rendered after the end of each file (default: the processor's tail length)
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+struct Options
+{
+    juce::File outputDir, stateFile;
+    int blockSize = 8192;
+    int subBlockSize = 0; //0 keeps the state's
+    int numJobs = juce::SystemStats::getNumCpus();
+    double tailSeconds = -1.0; //negative means ask the processor
+    juce::Array<juce::File> inputs;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg(argv[i]);
+        auto hasValue = i + 1 < argc;
+
+        if (arg == "--output" && hasValue)
+            options.outputDir = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else if (arg == "--state" && hasValue)
+            options.stateFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        else if (arg == "--block" && hasValue)
+            options.blockSize = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--sub-block" && hasValue)
+            options.subBlockSize = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--jobs" && hasValue)
+            options.numJobs = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--tail" && hasValue)
+            options.tailSeconds = juce::String(argv[++i]).getDoubleValue();
+        else if (arg.startsWith("--"))
+            return false;
+        else
+            options.inputs.add(juce::File::getCurrentWorkingDirectory().getChildFile(arg));
+    }
+
+    return options.outputDir != juce::File() && options.inputs.isEmpty() == false && options.blockSize > 0 && options.numJobs > 0;
+}
+
+//follows a link in the file itself or in the directory holding it
+juce::File resolve(const juce::File& file)
+{
+    return file.getParentDirectory().getLinkedTarget().getChildFile(file.getFileName()).getLinkedTarget();
+}
+
+//one output per input, named after it. Fails if two inputs share a name or an output would overwrite an input.
+juce::String makeOutputs(const Options& options, juce::Array<juce::File>& outputs)
+{
+    juce::Array<juce::File> resolvedInputs;
+    for (const auto& input : options.inputs)
+        resolvedInputs.add(resolve(input));
+
+    for (const auto& input : options.inputs)
+    {
+        auto output = options.outputDir.getChildFile(input.getFileName());
+        if (resolvedInputs.contains(resolve(output)))
+            return output.getFullPathName() + " is one of the inputs";
+        if (outputs.contains(output))
+            return "more than one input is named " + input.getFileName();
+        outputs.add(output);
+    }
+
+    return {};
+}
+
+//everything one worker thread owns
+struct Worker
+{
+    Project13AudioProcessor processor;
+    juce::AudioFormatManager formats;
+
+    juce::String render(const juce::File& input, const juce::File& output, const Options& options)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(input));
+        if (reader == nullptr)
+            return "can't read " + input.getFullPathName();
+
+        //the processor runs on the file's own layout, mono up to 7.1.4
+        const auto numFileChannels = static_cast<int>(reader->numChannels);
+        const auto numProcessorChannels = numFileChannels;
+        if (numFileChannels > Project13AudioProcessor::MaxChannels)
+            return input.getFileName() + " has more than " + juce::String(Project13AudioProcessor::MaxChannels) + " channels";
+
+        auto* format = formats.findFormatForFileExtension(output.getFileExtension());
+        if (format == nullptr)
+            return "no writer for " + output.getFileExtension();
+
+        output.deleteFile();
+        auto stream = output.createOutputStream();
+        if (stream == nullptr)
+            return "can't write " + output.getFullPathName();
+
+        const auto bitsPerSample = juce::jmin(static_cast<int>(reader->bitsPerSample), 24);
+        std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), reader->sampleRate, static_cast<unsigned int>(numFileChannels), bitsPerSample, {}, 0));
+        if (writer == nullptr)
+            return "can't create a writer for " + output.getFullPathName();
+        stream.release(); //the writer owns it now
+
+        const auto sampleRate = reader->sampleRate;
+        const auto blockSize = options.blockSize;
+
+        processor.setNonRealtime(true);
+        processor.setPlayConfigDetails(numProcessorChannels, numProcessorChannels, sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        const auto tailSeconds = options.tailSeconds >= 0.0 ? options.tailSeconds : processor.getTailLengthSeconds();
+        const auto inputLength = reader->lengthInSamples;
+        const auto outputLength = inputLength + static_cast<juce::int64>(tailSeconds * sampleRate);
+
+        juce::AudioBuffer<float> buffer(numProcessorChannels, blockSize);
+        juce::MidiBuffer midi;
+        std::array<const float*, Project13AudioProcessor::MaxChannels> writePointers {};
+
+        //the first 'latency' samples out of the processor are discarded, so render that much extra at the end.
+        //A restored routing only takes effect in the first block, so that is when the latency is known.
+        juce::int64 rendered = 0, latency = 0, samplesToDiscard = 0;
+        while (rendered < outputLength + latency)
+        {
+            const auto numSamples = static_cast<int>(juce::jmin<juce::int64>(blockSize, outputLength + latency - rendered));
+
+            buffer.clear();
+            if (rendered < inputLength)
+            {
+                const auto numToRead = static_cast<int>(juce::jmin<juce::int64>(numSamples, inputLength - rendered));
+                reader->read(&buffer, 0, numToRead, rendered, true, numFileChannels > 1);
+            }
+
+            juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), numProcessorChannels, 0, numSamples);
+            processor.processBlock(block, midi);
+
+            if (rendered == 0)
+                latency = samplesToDiscard = processor.getProcessingLatencySamples();
+
+            const auto discard = static_cast<int>(juce::jmin<juce::int64>(samplesToDiscard, numSamples));
+            samplesToDiscard -= discard;
+
+            for (int ch = 0; ch < numFileChannels; ++ch)
+                writePointers[static_cast<size_t>(ch)] = buffer.getReadPointer(ch, discard);
+
+            if (numSamples > discard)
+                writer->writeFromFloatArrays(writePointers.data(), numFileChannels, numSamples - discard);
+
+            rendered += numSamples;
+        }
+
+        processor.releaseResources();
+        return {};
+    }
+};
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit; //the APVTS needs a message manager
+
+    Options options;
+    if (parseOptions(argc, argv, options) == false)
+    {
+        std::cerr << "usage: Project13Renderer --output <dir> [--state <file>] [--block <samples>] [--sub-block <samples>] [--jobs <n>] [--tail <seconds>] <input files...>" << std::endl;
+        return 1;
+    }
+
+    juce::MemoryBlock state;
+    if (options.stateFile != juce::File() && options.stateFile.loadFileAsData(state) == false)
+    {
+        std::cerr << "can't read state " << options.stateFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    if (options.outputDir.createDirectory().failed())
+    {
+        std::cerr << "can't create " << options.outputDir.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    juce::Array<juce::File> outputs;
+    if (auto error = makeOutputs(options, outputs); error.isNotEmpty())
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    //processors are created and restored here on the message thread, then handed to the workers
+    const auto numWorkers = juce::jmin(options.numJobs, options.inputs.size());
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto worker = std::make_unique<Worker>();
+        worker->formats.registerBasicFormats();
+        //the workers already fill the cores, so a processor only spreads its own work when it is alone
+        worker->processor.setUseWorkerThreads(numWorkers == 1);
+        if (state.getSize() > 0)
+            worker->processor.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+        if (options.subBlockSize > 0)
+            worker->processor.setSubBlockSize(options.subBlockSize);
+        workers.push_back(std::move(worker));
+    }
+
+    std::atomic<int> nextInput {0};
+    std::atomic<bool> anyFailed {false};
+    std::mutex printLock;
+
+    auto runWorker = [&](Worker& worker)
+    {
+        for (auto index = nextInput.fetch_add(1); index < options.inputs.size(); index = nextInput.fetch_add(1))
+        {
+            const auto& input = options.inputs.getReference(index);
+            const auto& output = outputs.getReference(index);
+
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+            const auto error = worker.render(input, output, options);
+            const auto elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+
+            std::lock_guard<std::mutex> lock(printLock);
+            if (error.isNotEmpty())
+            {
+                anyFailed = true;
+                std::cerr << "failed: " << error << std::endl;
+            }
+            else
+            {
+                std::cout << input.getFileName() << " -> " << output.getFullPathName()
+                          << " (" << juce::String(elapsedSeconds, 2) << " s)" << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (auto& worker : workers)
+        threads.emplace_back(runWorker, std::ref(*worker));
+
+    for (auto& t : threads)
+        t.join();
+
+    return anyFailed ? 1 : 0;
+}